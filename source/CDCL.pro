@@ -1,7 +1,8 @@
-QT += core
-QT -= gui
+QT -= core gui
 
 CONFIG += c++14
+LIBS += -pthread
+QMAKE_CXXFLAGS += -pthread
 
 TARGET = CDCL
 CONFIG += console
@@ -9,23 +10,44 @@ CONFIG -= app_bundle
 
 TEMPLATE = app
 
+include(optimize.pri)
+
 SOURCES += main.cpp \
     partial_valuation.cpp \
     solver.cpp \
-    choice.cpp
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which as been marked deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+    clause_arena.cpp \
+    shared_clauses.cpp \
+    variable_heap.cpp \
+    restart_policy.cpp \
+    dimacs_parser.cpp \
+    preprocessor.cpp \
+    clause_sharing.cpp \
+    portfolio.cpp \
+    cube_and_conquer.cpp \
+    resource_usage.cpp \
+    proof_writer.cpp \
+    batch.cpp \
+    literal_scan.cpp
 
 HEADERS += \
     partial_valuation.h \
     solver.h \
-    choice.h
+    choice.h \
+    clause_arena.h \
+    shared_clauses.h \
+    watcher.h \
+    variable_heap.h \
+    restart_policy.h \
+    dimacs_parser.h \
+    preprocessor.h \
+    clause_sharing.h \
+    portfolio.h \
+    cube_and_conquer.h \
+    resource_usage.h \
+    proof_writer.h \
+    batch.h \
+    literal_scan.h
+
+DISTFILES += \
+    optimize.pri \
+    pgo.sh
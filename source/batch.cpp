@@ -0,0 +1,175 @@
+#include "batch.h"
+
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <dirent.h>
+
+namespace
+{
+const char* resultName(SolveResult result)
+{
+    switch (result)
+    {
+    case SolveResult::Sat:
+        return "SAT";
+    case SolveResult::Unsat:
+        return "UNSAT";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+bool hasCnfExtension(const std::string& name)
+{
+    return name.size() > 4 && name.compare(name.size() - 4, 4, ".cnf") == 0;
+}
+}
+
+BatchSolver::BatchSolver(std::vector<std::string> paths, unsigned threads)
+    : m_paths(std::move(paths)), m_threads(threads), m_next(0)
+{
+    if (threads == 0)
+    {
+        throw std::runtime_error{"Batch solving needs at least one thread"};
+    }
+}
+
+std::vector<std::string> BatchSolver::listInputs(const std::string& path)
+{
+    std::vector<std::string> paths;
+    if (DIR* dir = opendir(path.c_str()))
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (hasCnfExtension(name))
+            {
+                paths.push_back(path + "/" + name);
+            }
+        }
+        closedir(dir);
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::ifstream list{path};
+    if (!list)
+    {
+        throw std::runtime_error{"Can't open " + path};
+    }
+    std::string line;
+    while (std::getline(list, line))
+    {
+        // the list may come from a script run on Windows
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#')
+        {
+            paths.push_back(line);
+        }
+    }
+    return paths;
+}
+
+void BatchSolver::write(std::ostream& out, const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    out << line << std::flush;
+}
+
+void BatchSolver::runWorker(unsigned index, std::ostream& out)
+{
+    // reused for all files of this worker
+    DimacsParser parser;
+    DimacsFormula formula;
+    std::ostringstream line;
+
+    std::size_t task;
+    while ((task = m_next++) < m_paths.size())
+    {
+        const std::string& path = m_paths[task];
+        line.str("");
+        line << path << "," << index << ",";
+
+        // anything can fail on one instance (a bad file, bad_alloc on a huge one), the rest still run
+        try
+        {
+            parser.parseFile(path, formula);
+
+            auto start = std::chrono::steady_clock::now();
+            Solver solver{formula};
+            solver.setBudget(Budget);
+            solver.solve2();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            SolverStats stats = solver.stats();
+            line << resultName(solver.status()) << "," << 1000 * formula.stats.seconds << ","
+                 << 1000 * seconds << "," << stats.decisions << "," << stats.propagations << ","
+                 << stats.conflicts << "," << stats.learnedClauses << "\n";
+
+            std::lock_guard<std::mutex> lock(m_outputMutex);
+            m_solveSeconds += seconds;
+            switch (solver.status())
+            {
+            case SolveResult::Sat:
+                m_sat++;
+                break;
+            case SolveResult::Unsat:
+                m_unsat++;
+                break;
+            default:
+                m_unknown++;
+                break;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            line.str("");
+            line << path << "," << index << ",ERROR,,,,,,\n";
+            // a half loaded formula may be huge, it shouldn't stay around for the next files
+            formula = DimacsFormula();
+            std::lock_guard<std::mutex> lock(m_outputMutex);
+            m_errors++;
+            std::cerr << path << ": " << e.what() << std::endl;
+        }
+        write(out, line.str());
+    }
+}
+
+void BatchSolver::run(std::ostream& out)
+{
+    auto start = std::chrono::steady_clock::now();
+    out << "instance,worker,result,load_ms,solve_ms,decisions,propagations,conflicts,learned_clauses\n";
+
+    // no point in workers which would never get a file
+    unsigned threads = std::max<std::size_t>(1, std::min<std::size_t>(m_threads, m_paths.size()));
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers.emplace_back(&BatchSolver::runWorker, this, i, std::ref(out));
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string BatchSolver::getInfo() const
+{
+    std::ostringstream info;
+    info << "Batch: " << m_paths.size() << " instances on " << m_threads << " workers, "
+         << m_sat << " SAT, " << m_unsat << " UNSAT, " << m_unknown << " UNKNOWN, "
+         << m_errors << " errors\n";
+    info << "Solving took " << m_solveSeconds << " s of " << m_seconds << " s wall time, "
+         << (m_seconds > 0 ? m_paths.size() / m_seconds : 0) << " instances/s";
+    return info.str();
+}
@@ -0,0 +1,83 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "solver.h"
+#include "dimacs_parser.h"
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief The BatchSolver class - solves many independent CNF files in one process, on a pool
+ * of worker threads.
+ *
+ * @details Workers take the next file from a shared counter, so long instances don't hold up
+ * the short ones behind them. Every file is solved by its own Solver, but each worker keeps one
+ * DimacsParser and one DimacsFormula for all of its files, so the read buffer, literal stamps
+ * and the literal vector are allocated once per worker instead of once per file.
+ *
+ * A CSV line is written for every file as soon as it is solved, so lines come in the order in
+ * which files finish and not in the order of the input.
+ */
+class BatchSolver
+{
+public:
+    /**
+     * @param paths - CNF files to solve
+     * @param threads - number of workers, at least one
+     */
+    BatchSolver(std::vector<std::string> paths, unsigned threads);
+
+    /**
+     * @brief listInputs - all *.cnf files in the directory, sorted by name, or the paths
+     * in a list file, one per line (empty lines and lines starting with # are skipped)
+     * @throws std::runtime_error if path can't be read
+     */
+    static std::vector<std::string> listInputs(const std::string& path);
+
+    /**
+     * @brief Budget - limits of every instance, after which it's given up as UNKNOWN
+     */
+    SolveBudget Budget;
+
+    /**
+     * @brief run - solves all files, streaming the header and one CSV line per file to out
+     */
+    void run(std::ostream& out);
+
+    /**
+     * @brief errors - number of files which couldn't be read, parsed or solved
+     */
+    std::size_t errors() const
+    {
+        return m_errors;
+    }
+
+    std::string getInfo() const;
+
+private:
+    void runWorker(unsigned index, std::ostream& out);
+
+    /**
+     * @brief write - writes the line to out as a whole, lines of different workers never mix
+     */
+    void write(std::ostream& out, const std::string& line);
+
+    std::vector<std::string> m_paths;
+    unsigned m_threads;
+
+    std::atomic<std::size_t> m_next;
+
+    std::mutex m_outputMutex;
+    std::size_t m_sat = 0;
+    std::size_t m_unsat = 0;
+    std::size_t m_unknown = 0;
+    std::size_t m_errors = 0;
+    double m_solveSeconds = 0;
+    double m_seconds = 0;
+};
+
+#endif // BATCH_H
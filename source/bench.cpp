@@ -0,0 +1,706 @@
+#include "solver.h"
+#include "dimacs_parser.h"
+#include "resource_usage.h"
+#include "literal_scan.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+#include <memory>
+#include <dirent.h>
+
+/**
+ * Benchmark runner: solves every instance of a corpus several times with solve2 and reports
+ * median times, search speed and memory, optionally compared against an earlier run.
+ *
+ *   bench [options] [file.cnf ...]
+ *     --corpus DIR      all *.cnf files in DIR
+ *     --repeats N       runs per instance, the median is reported (3)
+ *     --timeout S       seconds per run, after which the run counts as a timeout (60)
+ *     --csv FILE        writes the results as CSV
+ *     --json FILE       writes the results as JSON
+ *     --baseline FILE   CSV of an earlier run, slower instances are reported as regressions
+ *     --threshold P     how many percent slower is a regression (10)
+ *     --generate DIR    writes the generated scaling set into DIR and exits
+ *     --proof FORMAT    every run writes a DRAT proof in binary or text format to bench.drat
+ *     --proof-thread    proofs are written by a flush thread
+ *     --scan            microbenchmark of the clause scan implementations (firstNonFalse) and exits
+ *
+ * Without files or a corpus, the CNFs bundled in ../source and the generated scaling set are run.
+ * Exit code is 1 if there was a regression or a wrong answer, 2 if the benchmark couldn't run.
+ */
+
+namespace
+{
+
+const double c_noiseFloorMs = 5;
+
+const char* const c_proofFile = "bench.drat";
+
+enum class Expected
+{
+    Sat,
+    Unsat,
+    Unknown
+};
+
+struct Instance
+{
+    std::string name;
+    // empty for generated instances
+    std::string path;
+    std::string dimacs;
+    Expected expected = Expected::Unknown;
+};
+
+struct RunResult
+{
+    SolveResult result = SolveResult::Unknown;
+    double wallMs = 0;
+    double cpuMs = 0;
+    unsigned long long conflicts = 0;
+    unsigned long long propagations = 0;
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string result;
+    bool wrong = false;
+    unsigned repeats = 0;
+    double loadMs = 0;
+    double wallMedianMs = 0;
+    double wallMinMs = 0;
+    double cpuMedianMs = 0;
+    unsigned long long conflicts = 0;
+    unsigned long long propagations = 0;
+    double conflictsPerSecond = 0;
+    double propagationsPerSecond = 0;
+    double peakMemoryMB = 0;
+};
+
+struct Options
+{
+    std::vector<std::string> files;
+    std::string corpus;
+    unsigned repeats = 3;
+    double timeout = 60;
+    std::string csv;
+    std::string json;
+    std::string baseline;
+    double threshold = 10;
+    std::string generate;
+    // empty if runs don't write proofs
+    std::string proof;
+    bool proofThread = false;
+    bool scan = false;
+};
+
+std::string resultName(SolveResult result)
+{
+    return result == SolveResult::Sat ? "SAT" : result == SolveResult::Unsat ? "UNSAT" : "TIMEOUT";
+}
+
+/**
+ * @brief randomThreeSat - uniform random 3-SAT, near the threshold ratio 4.26 half of them are SAT
+ */
+std::string randomThreeSat(unsigned nVars, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<unsigned> variable(1, nVars);
+    const unsigned nClauses = static_cast<unsigned>(4.26 * nVars + 0.5);
+
+    std::ostringstream dimacs;
+    dimacs << "c random 3-SAT, seed " << seed << "\np cnf " << nVars << " " << nClauses << "\n";
+    for (unsigned i = 0; i < nClauses; i++)
+    {
+        unsigned vars[3];
+        for (unsigned j = 0; j < 3; j++)
+        {
+            // three different variables, so that no clause is shorter or a tautology
+            do
+            {
+                vars[j] = variable(generator);
+            } while (std::find(vars, vars + j, vars[j]) != vars + j);
+            dimacs << (generator() % 2 ? "-" : "") << vars[j] << " ";
+        }
+        dimacs << "0\n";
+    }
+    return dimacs.str();
+}
+
+/**
+ * @brief pigeonhole - n+1 pigeons in n holes, UNSAT and exponentially hard for resolution
+ */
+std::string pigeonhole(unsigned holes)
+{
+    const unsigned pigeons = holes + 1;
+    auto var = [holes](unsigned pigeon, unsigned hole) { return pigeon * holes + hole + 1; };
+
+    std::ostringstream dimacs;
+    dimacs << "c pigeonhole " << pigeons << " into " << holes << "\np cnf " << pigeons * holes << " "
+           << pigeons + holes * pigeons * (pigeons - 1) / 2 << "\n";
+    for (unsigned p = 0; p < pigeons; p++)
+    {
+        for (unsigned h = 0; h < holes; h++)
+        {
+            dimacs << var(p, h) << " ";
+        }
+        dimacs << "0\n";
+    }
+    for (unsigned h = 0; h < holes; h++)
+    {
+        for (unsigned p1 = 0; p1 < pigeons; p1++)
+        {
+            for (unsigned p2 = p1 + 1; p2 < pigeons; p2++)
+            {
+                dimacs << -static_cast<int>(var(p1, h)) << " " << -static_cast<int>(var(p2, h)) << " 0\n";
+            }
+        }
+    }
+    return dimacs.str();
+}
+
+std::vector<Instance> scalingSet()
+{
+    std::vector<Instance> instances;
+    for (unsigned nVars : {100, 125, 150, 175, 200})
+    {
+        Instance instance;
+        instance.name = "rand3-" + std::to_string(nVars);
+        instance.dimacs = randomThreeSat(nVars, nVars);
+        instances.push_back(instance);
+    }
+    for (unsigned holes : {5, 6, 7})
+    {
+        Instance instance;
+        instance.name = "php-" + std::to_string(holes);
+        instance.dimacs = pigeonhole(holes);
+        instance.expected = Expected::Unsat;
+        instances.push_back(instance);
+    }
+    return instances;
+}
+
+std::vector<Instance> bundledSet()
+{
+    const std::vector<std::pair<std::string, Expected>> files {
+        {"plsWrk.cnf", Expected::Sat}, {"test-SAT.cnf", Expected::Sat}, {"test-UNSAT.cnf", Expected::Unsat},
+        {"sat.cnf", Expected::Sat}, {"unsat.cnf", Expected::Unsat}, {"sudoku.cnf", Expected::Sat}};
+    std::vector<Instance> instances;
+    for (const auto& file : files)
+    {
+        Instance instance;
+        instance.name = file.first;
+        instance.path = "../source/" + file.first;
+        instance.expected = file.second;
+        instances.push_back(instance);
+    }
+    return instances;
+}
+
+std::vector<Instance> corpusSet(const std::string& directory)
+{
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr)
+    {
+        throw std::runtime_error{"Can't open corpus directory " + directory};
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".cnf") == 0)
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    std::vector<Instance> instances;
+    for (const std::string& name : names)
+    {
+        Instance instance;
+        instance.name = name;
+        instance.path = directory + "/" + name;
+        instances.push_back(instance);
+    }
+    return instances;
+}
+
+RunResult runOnce(const DimacsFormula& formula, const Options& options)
+{
+    RunResult run;
+
+    auto start = std::chrono::steady_clock::now();
+    std::clock_t cpuStart = std::clock();
+    {
+        Solver solver{formula};
+        SolveBudget budget;
+        budget.seconds = options.timeout;
+        solver.setBudget(budget);
+
+        // writing the proof is a part of the run
+        std::ofstream proofFile;
+        std::unique_ptr<ProofWriter> proof;
+        if (!options.proof.empty())
+        {
+            proofFile.open(c_proofFile, std::ios::binary);
+            proof.reset(new ProofWriter(proofFile, options.proof == "text" ? ProofFormat::Text : ProofFormat::Binary,
+                                        options.proofThread));
+            solver.setProofWriter(proof.get());
+        }
+
+        solver.solve2();
+        if (proof)
+        {
+            proof->finish();
+        }
+        run.result = solver.status();
+        SolverStats stats = solver.stats();
+        run.conflicts = stats.conflicts;
+        run.propagations = stats.propagations;
+    }
+    run.cpuMs = 1000.0 * (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    run.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return run;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    std::size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+BenchResult benchmark(const Instance& instance, const Options& options)
+{
+    DimacsFormula formula;
+    DimacsParser parser;
+    if (instance.path.empty())
+    {
+        std::istringstream in(instance.dimacs);
+        parser.parse(in, formula);
+    }
+    else
+    {
+        parser.parseFile(instance.path, formula);
+    }
+
+    BenchResult bench;
+    bench.name = instance.name;
+    bench.repeats = options.repeats;
+    bench.loadMs = formula.stats.seconds * 1000;
+
+    std::vector<double> wall, cpu;
+    SolveResult result = SolveResult::Unknown;
+    for (unsigned i = 0; i < options.repeats; i++)
+    {
+        RunResult run = runOnce(formula, options);
+        wall.push_back(run.wallMs);
+        cpu.push_back(run.cpuMs);
+        // the search is deterministic, every run does the same work
+        bench.conflicts = run.conflicts;
+        bench.propagations = run.propagations;
+        result = run.result;
+        if (result == SolveResult::Unknown)
+        {
+            // repeating a timeout only wastes time
+            bench.repeats = i + 1;
+            break;
+        }
+    }
+
+    bench.result = resultName(result);
+    bench.wrong = (instance.expected == Expected::Sat && result == SolveResult::Unsat) ||
+            (instance.expected == Expected::Unsat && result == SolveResult::Sat);
+    bench.wallMedianMs = median(wall);
+    bench.wallMinMs = *std::min_element(wall.begin(), wall.end());
+    bench.cpuMedianMs = median(cpu);
+    if (bench.wallMedianMs > 0)
+    {
+        bench.conflictsPerSecond = bench.conflicts / (bench.wallMedianMs / 1000);
+        bench.propagationsPerSecond = bench.propagations / (bench.wallMedianMs / 1000);
+    }
+    // peak of the whole process, so it only grows from one instance to the next
+    bench.peakMemoryMB = peakMemoryMegabytes();
+    return bench;
+}
+
+const char* const c_csvHeader = "instance,result,repeats,load_ms,wall_median_ms,wall_min_ms,cpu_median_ms,"
+                                "conflicts,propagations,conflicts_per_sec,propagations_per_sec,peak_rss_mb";
+
+void writeCsv(std::ostream& out, const std::vector<BenchResult>& results)
+{
+    out << c_csvHeader << "\n";
+    for (const BenchResult& r : results)
+    {
+        out << r.name << "," << r.result << "," << r.repeats << "," << r.loadMs << "," << r.wallMedianMs << ","
+            << r.wallMinMs << "," << r.cpuMedianMs << "," << r.conflicts << "," << r.propagations << ","
+            << r.conflictsPerSecond << "," << r.propagationsPerSecond << "," << r.peakMemoryMB << "\n";
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchResult>& results)
+{
+    out << "[\n";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        out << " {\"instance\": \"" << r.name << "\", \"result\": \"" << r.result << "\", \"repeats\": " << r.repeats
+            << ", \"loadMs\": " << r.loadMs << ", \"wallMedianMs\": " << r.wallMedianMs
+            << ", \"wallMinMs\": " << r.wallMinMs << ", \"cpuMedianMs\": " << r.cpuMedianMs
+            << ", \"conflicts\": " << r.conflicts << ", \"propagations\": " << r.propagations
+            << ", \"conflictsPerSecond\": " << r.conflictsPerSecond
+            << ", \"propagationsPerSecond\": " << r.propagationsPerSecond
+            << ", \"peakRssMB\": " << r.peakMemoryMB << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+/**
+ * @brief readBaseline - result and median wall time of every instance in a CSV written by writeCsv
+ */
+std::map<std::string, std::pair<std::string, double>> readBaseline(const std::string& path)
+{
+    std::ifstream in{path};
+    if (!in)
+    {
+        throw std::runtime_error{"Can't open baseline " + path};
+    }
+    std::string line;
+    std::getline(in, line);
+    if (line != c_csvHeader)
+    {
+        throw std::runtime_error{"Baseline " + path + " isn't a benchmark CSV"};
+    }
+
+    std::map<std::string, std::pair<std::string, double>> baseline;
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ','))
+        {
+            fields.push_back(field);
+        }
+        if (fields.size() >= 5)
+        {
+            baseline[fields[0]] = {fields[1], std::stod(fields[4])};
+        }
+    }
+    return baseline;
+}
+
+/**
+ * @brief compare - prints instances which got slower or changed their answer
+ * @return number of regressions
+ */
+unsigned compare(const std::vector<BenchResult>& results, const std::string& path, double threshold)
+{
+    auto baseline = readBaseline(path);
+    unsigned regressions = 0;
+    std::cout << "\nComparison with " << path << ":\n";
+    for (const BenchResult& r : results)
+    {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end())
+        {
+            std::cout << "  " << r.name << ": not in baseline\n";
+            continue;
+        }
+        const std::string& oldResult = it->second.first;
+        double oldMs = it->second.second;
+        double change = oldMs > 0 ? 100 * (r.wallMedianMs - oldMs) / oldMs : 0;
+
+        std::string verdict = "ok";
+        if (oldResult != r.result && oldResult != "TIMEOUT" && r.result != "TIMEOUT")
+        {
+            verdict = "ANSWER CHANGED";
+            regressions++;
+        }
+        else if (r.result == "TIMEOUT" && oldResult != "TIMEOUT")
+        {
+            verdict = "REGRESSION (timeout)";
+            regressions++;
+        }
+        else if (change > threshold && r.wallMedianMs - oldMs > c_noiseFloorMs)
+        {
+            verdict = "REGRESSION";
+            regressions++;
+        }
+        else if (change < -threshold && oldMs - r.wallMedianMs > c_noiseFloorMs)
+        {
+            verdict = "faster";
+        }
+        std::cout << "  " << r.name << ": " << oldMs << " ms -> " << r.wallMedianMs << " ms ("
+                  << (change >= 0 ? "+" : "") << change << "%) " << verdict << "\n";
+    }
+    return regressions;
+}
+
+/**
+ * @brief scanBenchmark - times every supported firstNonFalse implementation on random clauses of
+ * several lengths, in which all literals before a random position are false
+ * @return 1 if the implementations disagree
+ */
+int scanBenchmark()
+{
+    const unsigned nVars = 1 << 16;
+    const unsigned nClauses = 1 << 12;
+    const unsigned c_lengths[] = {8, 16, 32, 64, 256};
+    const ScanPath c_paths[] = {ScanPath::Scalar, ScanPath::Sse41, ScanPath::Avx2};
+
+    std::mt19937 random{1};
+    std::vector<Tribool> values(2 * (nVars + 1) + c_scanPadding, Tribool::Undefined);
+    std::vector<Literal> falseLits;
+    std::vector<Literal> otherLits;
+    for (unsigned var = 1; var <= nVars; var++)
+    {
+        // a random assignment of 3/4 of the variables
+        Literal l = random() % 2 ? var : -static_cast<Literal>(var);
+        if (random() % 4)
+        {
+            values[litIndex(l)] = Tribool::True;
+            values[litIndex(-l)] = Tribool::False;
+            falseLits.push_back(-l);
+            otherLits.push_back(l);
+        }
+        else
+        {
+            otherLits.push_back(l);
+            otherLits.push_back(-l);
+        }
+    }
+
+    std::cout << "firstNonFalse, dispatched to " << scanPathName(supportedScanPath()) << "\n";
+    bool mismatch = false;
+    for (unsigned length : c_lengths)
+    {
+        // an eighth of the clauses is all false
+        std::vector<Literal> literals;
+        for (unsigned i = 0; i < nClauses; i++)
+        {
+            unsigned firstNonFalse = random() % (length + length / 8);
+            for (unsigned j = 0; j < length; j++)
+            {
+                const std::vector<Literal>& from = j == firstNonFalse ? otherLits : falseLits;
+                literals.push_back(from[random() % from.size()]);
+            }
+        }
+
+        std::cout << "  length " << length << ":";
+        std::vector<int> expected;
+        for (ScanPath path : c_paths)
+        {
+            if (!isScanPathSupported(path))
+            {
+                continue;
+            }
+            std::vector<int> found(nClauses);
+            const unsigned rounds = (1 << 24) / (nClauses * length) + 1;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned round = 0; round < rounds; round++)
+            {
+                for (unsigned i = 0; i < nClauses; i++)
+                {
+                    found[i] = firstNonFalse(path, literals.data() + i * length, 0, length, values.data());
+                }
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            std::cout << " " << scanPathName(path) << " " << ns / (static_cast<double>(rounds) * nClauses) << " ns";
+
+            if (expected.empty())
+            {
+                expected = found;
+            }
+            else if (found != expected)
+            {
+                std::cout << " (MISMATCH)";
+                mismatch = true;
+            }
+        }
+        std::cout << " per clause" << std::endl;
+    }
+    return mismatch ? 1 : 0;
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error{"Missing value for " + arg};
+            }
+            return argv[++i];
+        };
+        if (arg == "--corpus")
+        {
+            options.corpus = value();
+        }
+        else if (arg == "--repeats")
+        {
+            options.repeats = std::max(1ul, std::stoul(value()));
+        }
+        else if (arg == "--timeout")
+        {
+            options.timeout = std::stod(value());
+        }
+        else if (arg == "--csv")
+        {
+            options.csv = value();
+        }
+        else if (arg == "--json")
+        {
+            options.json = value();
+        }
+        else if (arg == "--baseline")
+        {
+            options.baseline = value();
+        }
+        else if (arg == "--threshold")
+        {
+            options.threshold = std::stod(value());
+        }
+        else if (arg == "--generate")
+        {
+            options.generate = value();
+        }
+        else if (arg == "--proof")
+        {
+            options.proof = value();
+            if (options.proof != "binary" && options.proof != "text")
+            {
+                throw std::runtime_error{"Proof format must be binary or text"};
+            }
+        }
+        else if (arg == "--proof-thread")
+        {
+            options.proofThread = true;
+        }
+        else if (arg == "--scan")
+        {
+            options.scan = true;
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            throw std::runtime_error{"Unknown option " + arg};
+        }
+        else
+        {
+            options.files.push_back(arg);
+        }
+    }
+    return options;
+}
+
+}
+
+int runBenchmark(const Options& options);
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return runBenchmark(parseOptions(argc, argv));
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "bench: " << error.what() << std::endl;
+        return 2;
+    }
+}
+
+int runBenchmark(const Options& options)
+{
+    if (options.scan)
+    {
+        return scanBenchmark();
+    }
+
+    if (!options.generate.empty())
+    {
+        for (const Instance& instance : scalingSet())
+        {
+            std::ofstream out{options.generate + "/" + instance.name + ".cnf"};
+            if (!out)
+            {
+                throw std::runtime_error{"Can't write into " + options.generate};
+            }
+            out << instance.dimacs;
+        }
+        return 0;
+    }
+
+    std::vector<Instance> instances;
+    if (!options.corpus.empty())
+    {
+        instances = corpusSet(options.corpus);
+    }
+    for (const std::string& file : options.files)
+    {
+        Instance instance;
+        instance.name = file.substr(file.find_last_of('/') + 1);
+        instance.path = file;
+        instances.push_back(instance);
+    }
+    if (instances.empty())
+    {
+        instances = bundledSet();
+        for (const Instance& instance : scalingSet())
+        {
+            instances.push_back(instance);
+        }
+    }
+
+    std::vector<BenchResult> results;
+    unsigned wrong = 0;
+    for (const Instance& instance : instances)
+    {
+        BenchResult result = benchmark(instance, options);
+        std::cout << result.name << ": " << result.result << (result.wrong ? " (WRONG)" : "")
+                  << ", median " << result.wallMedianMs << " ms, cpu " << result.cpuMedianMs << " ms, "
+                  << static_cast<unsigned long long>(result.conflictsPerSecond) << " conflicts/s, "
+                  << static_cast<unsigned long long>(result.propagationsPerSecond) << " propagations/s, "
+                  << result.peakMemoryMB << " MB" << std::endl;
+        wrong += result.wrong;
+        results.push_back(result);
+    }
+
+    if (!options.csv.empty())
+    {
+        std::ofstream out{options.csv};
+        writeCsv(out, results);
+    }
+    if (!options.json.empty())
+    {
+        std::ofstream out{options.json};
+        writeJson(out, results);
+    }
+
+    unsigned regressions = 0;
+    if (!options.baseline.empty())
+    {
+        regressions = compare(results, options.baseline, options.threshold);
+    }
+    if (wrong || regressions)
+    {
+        std::cout << "\n" << wrong << " wrong answers, " << regressions << " regressions" << std::endl;
+        return 1;
+    }
+    return 0;
+}
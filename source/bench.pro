@@ -0,0 +1,44 @@
+QT -= core gui
+
+CONFIG += c++14
+
+TARGET = bench
+CONFIG += console
+CONFIG -= app_bundle
+LIBS += -pthread
+QMAKE_CXXFLAGS += -pthread
+
+TEMPLATE = app
+
+include(optimize.pri)
+
+# everything from CDCL.pro except its main.cpp
+SOURCES += bench.cpp \
+    partial_valuation.cpp \
+    solver.cpp \
+    clause_arena.cpp \
+    shared_clauses.cpp \
+    variable_heap.cpp \
+    restart_policy.cpp \
+    dimacs_parser.cpp \
+    preprocessor.cpp \
+    clause_sharing.cpp \
+    resource_usage.cpp \
+    proof_writer.cpp \
+    literal_scan.cpp
+
+HEADERS += \
+    partial_valuation.h \
+    solver.h \
+    choice.h \
+    clause_arena.h \
+    shared_clauses.h \
+    watcher.h \
+    variable_heap.h \
+    restart_policy.h \
+    dimacs_parser.h \
+    preprocessor.h \
+    clause_sharing.h \
+    resource_usage.h \
+    proof_writer.h \
+    literal_scan.h
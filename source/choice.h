@@ -3,12 +3,39 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
 
 using Literal = int;
 using Clause = std::vector<Literal>;
-using ClauseIndex = int;
+using ClauseIndex = std::uint32_t;
+
+/**
+ * @brief NullClause - ClauseIndex which doesn't refer to any clause (e.g. reason of a decided literal)
+ */
+const ClauseIndex NullClause = UINT32_MAX;
+
+/**
+ * @brief c_sharedClause - bit of a ClauseIndex which marks a clause of SharedClauses,
+ * offsets into a ClauseArena stay below it
+ */
+const ClauseIndex c_sharedClause = 1u << 31;
+
+/**
+ * @brief c_maxVariable - largest variable a formula may have, so that tables indexed by
+ * litIndex (with some padding) still have an unsigned size
+ */
+const unsigned c_maxVariable = (1u << 30) - 1;
+
+/**
+ * @brief litIndex - encodes a literal as 2*var+sign, so that tables indexed by literals
+ * keep both polarities of a variable next to each other
+ */
+inline unsigned litIndex(Literal l)
+{
+    return 2u * std::abs(l) + (l < 0);
+}
 
 /**
  * Template for printing out vectors into streams
@@ -37,65 +64,4 @@ enum class Tribool: int8_t
     Undefined
 };
 
-class LiteralInfo
-{
-public:
-    LiteralInfo(Tribool val, unsigned lvl) : value(val), level(lvl), weight(0)
-    {
-    }
-
-    LiteralInfo() : value(Tribool::Undefined), level(0), weight(0)
-    {
-    }
-
-    bool operator == (const LiteralInfo& op2) const;
-
-    std::vector<ClauseIndex> posWatched;
-    std::vector<ClauseIndex> negWatched;
-    Tribool value;
-    unsigned level;
-    float weight;
-};
-
-const LiteralInfo c_defaultLiteralInfo = LiteralInfo();
-
-class Choice
-{
-public:
-    /**
-     * @brief Choice constructor of decided literal or its negation afterwards
-     * @param lit
-     * @param level
-     * @param isDecided
-     */
-    Choice(Literal lit, unsigned level, bool isDecided) : lit(lit), level(level), reason(-1), isDecided(isDecided)
-    {
-//        if ((reason == nullptr || reason->empty()) && isDecided == false)
-//        {
-//            std::cout << "reason is empty" << std::endl;
-//        }
-    }
-
-    /**
-     * @brief Choice constructor of unit propagated literal
-     * @param l
-     * @param level
-     * @param reason clause
-     */
-    Choice(Literal l, unsigned level, ClauseIndex reason) : lit(l), level(level), reason(reason), isDecided(false)
-    {
-//        if (reason->empty() && isDecided == false)
-//        {
-//            std::cout << "reason is empty" << std::endl;
-//        }
-    }
-
-    bool hasReason() const;
-
-    Literal lit;
-    unsigned level;
-    ClauseIndex reason;
-    bool isDecided;
-};
-
 #endif // CHOISE_H
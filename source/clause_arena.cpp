@@ -0,0 +1,59 @@
+#include "clause_arena.h"
+
+#include <stdexcept>
+
+ClauseIndex ClauseArena::alloc(const Clause& lits, bool learned)
+{
+    std::size_t offset = m_memory.size();
+    if (offset + ArenaClause::c_headerWords + lits.size() >= c_sharedClause)
+    {
+        throw std::runtime_error("clause arena is out of 31-bit offsets");
+    }
+
+    m_memory.push_back(lits.size());
+    m_memory.push_back(learned ? ArenaClause::c_learnedBit : 0);
+    m_memory.push_back(0);
+    m_memory.insert(m_memory.end(), lits.begin(), lits.end());
+
+    ArenaClause(m_memory.data() + offset).setActivity(0);
+    return offset;
+}
+
+void ClauseArena::free(ClauseIndex ci)
+{
+    ArenaClause c = (*this)[ci];
+    if (c.deleted())
+    {
+        return;
+    }
+    c.m_header[1] |= ArenaClause::c_deletedBit;
+    m_wasted += ArenaClause::c_headerWords + c.size();
+}
+
+void ClauseArena::relocate(ClauseIndex& ci, ClauseArena& to)
+{
+    ArenaClause c = (*this)[ci];
+    if (c.relocated())
+    {
+        ci = c.m_header[2];
+        return;
+    }
+
+    ClauseIndex newIndex = to.m_memory.size();
+    to.m_memory.insert(to.m_memory.end(), c.m_header, c.m_header + ArenaClause::c_headerWords + c.size());
+
+    c.m_header[1] |= ArenaClause::c_relocatedBit;
+    c.m_header[2] = newIndex;
+    ci = newIndex;
+}
+
+std::ostream& operator << (std::ostream& out, const ArenaClause& c)
+{
+    if (!c.empty())
+    {
+        out << '[';
+        std::copy(c.begin(), c.end(), std::ostream_iterator<Literal>(out, ", "));
+        out << "\b\b]";
+    }
+    return out;
+}
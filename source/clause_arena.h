@@ -0,0 +1,198 @@
+#ifndef CLAUSE_ARENA_H
+#define CLAUSE_ARENA_H
+
+#include "choice.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief The ArenaClause class - non-owning view of a clause stored inside a ClauseArena.
+ *
+ * @details Every clause in the arena starts with a header of c_headerWords 32-bit words:
+ *  - word 0: number of literals
+ *  - word 1: flags (learned, deleted, relocated, vivified) in the low bits, LBD in the rest
+ *  - word 2: activity (float bits), or the new offset once the clause is relocated
+ * followed by the literals themselves. The view is invalidated when the arena grows.
+ */
+class ArenaClause
+{
+public:
+    static const unsigned c_headerWords = 3;
+
+    explicit ArenaClause(uint32_t* header) : m_header(header)
+    {
+    }
+
+    unsigned size() const
+    {
+        return m_header[0];
+    }
+
+    bool empty() const
+    {
+        return m_header[0] == 0;
+    }
+
+    bool learned() const
+    {
+        return m_header[1] & c_learnedBit;
+    }
+
+    bool deleted() const
+    {
+        return m_header[1] & c_deletedBit;
+    }
+
+    bool relocated() const
+    {
+        return m_header[1] & c_relocatedBit;
+    }
+
+    /**
+     * @brief vivified - whether inprocessing already tried to shorten the clause
+     */
+    bool vivified() const
+    {
+        return m_header[1] & c_vivifiedBit;
+    }
+
+    void setVivified()
+    {
+        m_header[1] |= c_vivifiedBit;
+    }
+
+    unsigned lbd() const
+    {
+        return m_header[1] >> c_flagBits;
+    }
+
+    void setLbd(unsigned lbd)
+    {
+        m_header[1] = (m_header[1] & c_flagMask) | (lbd << c_flagBits);
+    }
+
+    float activity() const
+    {
+        float a;
+        std::memcpy(&a, m_header + 2, sizeof(a));
+        return a;
+    }
+
+    void setActivity(float a)
+    {
+        std::memcpy(m_header + 2, &a, sizeof(a));
+    }
+
+    Literal& operator[](unsigned i)
+    {
+        return begin()[i];
+    }
+
+    Literal operator[](unsigned i) const
+    {
+        return begin()[i];
+    }
+
+    Literal* begin() const
+    {
+        // int and unsigned int may alias each other, so this is well defined
+        return reinterpret_cast<Literal*>(m_header + c_headerWords);
+    }
+
+    Literal* end() const
+    {
+        return begin() + size();
+    }
+
+private:
+    friend class ClauseArena;
+
+    static const uint32_t c_learnedBit = 1u;
+    static const uint32_t c_deletedBit = 1u << 1;
+    static const uint32_t c_relocatedBit = 1u << 2;
+    static const uint32_t c_vivifiedBit = 1u << 3;
+    static const unsigned c_flagBits = 4;
+    static const uint32_t c_flagMask = (1u << c_flagBits) - 1;
+
+    uint32_t* m_header;
+};
+
+std::ostream& operator << (std::ostream& out, const ArenaClause& c);
+
+/**
+ * @brief The ClauseArena class - all clauses of a formula stored in one contiguous block
+ * of memory and addressed by 32-bit offsets (ClauseIndex).
+ *
+ * @details Freed clauses are only marked as deleted, their memory is reclaimed by moving
+ * the live clauses into a fresh arena (see Solver::garbageCollect).
+ */
+class ClauseArena
+{
+public:
+    ClauseArena() : m_wasted(0)
+    {
+    }
+
+    /**
+     * @brief alloc - copies the given literals into the arena
+     * @param lits - literals of the clause
+     * @param learned - whether the clause was learned during search
+     * @return offset of the new clause
+     */
+    ClauseIndex alloc(const Clause& lits, bool learned);
+
+    ArenaClause operator[](ClauseIndex ci)
+    {
+        return ArenaClause(m_memory.data() + ci);
+    }
+
+    const ArenaClause operator[](ClauseIndex ci) const
+    {
+        return ArenaClause(const_cast<uint32_t*>(m_memory.data()) + ci);
+    }
+
+    /**
+     * @brief free - marks the clause as deleted, its memory is wasted until the next collection
+     */
+    void free(ClauseIndex ci);
+
+    /**
+     * @brief relocate - moves the clause into another arena, leaving a forwarding offset behind
+     * @param ci - offset of the clause in this arena, it is updated to the offset in the other one
+     * @param to - arena which receives the clause
+     */
+    void relocate(ClauseIndex& ci, ClauseArena& to);
+
+    void reserve(std::size_t words)
+    {
+        m_memory.reserve(words);
+    }
+
+    /**
+     * @brief size - number of 32-bit words in use, including wasted ones
+     */
+    std::size_t size() const
+    {
+        return m_memory.size();
+    }
+
+    std::size_t wasted() const
+    {
+        return m_wasted;
+    }
+
+    void swap(ClauseArena& other)
+    {
+        m_memory.swap(other.m_memory);
+        std::swap(m_wasted, other.m_wasted);
+    }
+
+private:
+    std::vector<uint32_t> m_memory;
+    std::size_t m_wasted;
+};
+
+#endif // CLAUSE_ARENA_H
@@ -0,0 +1,73 @@
+#include "clause_sharing.h"
+
+ExportRing::ExportRing(std::size_t capacity)
+    : m_capacity(capacity), m_data(new std::atomic<Literal>[capacity]), m_reserved(0), m_published(0)
+{
+    for (std::size_t i = 0; i < m_capacity; i++)
+    {
+        m_data[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ExportRing::push(const Clause& clause, unsigned lbd)
+{
+    if (clause.size() > c_maxClauseSize)
+    {
+        return;
+    }
+
+    std::uint64_t start = m_published.load(std::memory_order_relaxed);
+    std::uint64_t end = start + clause.size() + 2;
+    m_reserved.store(end, std::memory_order_relaxed);
+    // readers must see the reservation before any of the overwritten slots
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_data[start % m_capacity].store(clause.size(), std::memory_order_relaxed);
+    m_data[(start + 1) % m_capacity].store(lbd, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < clause.size(); i++)
+    {
+        m_data[(start + 2 + i) % m_capacity].store(clause[i], std::memory_order_relaxed);
+    }
+
+    m_published.store(end, std::memory_order_release);
+}
+
+void ExportRing::read(std::uint64_t& cursor, std::vector<Literal>& out) const
+{
+    std::uint64_t published = m_published.load(std::memory_order_acquire);
+    if (published - cursor > m_capacity)
+    {
+        // the writer went around the ring, clauses before published - capacity are gone
+        // and the first complete one after that is unknown, so all of them are skipped
+        cursor = published;
+        return;
+    }
+
+    std::size_t outStart = out.size();
+    std::uint64_t pos = cursor;
+    while (pos < published)
+    {
+        std::size_t size = slot(pos);
+        if (size > c_maxClauseSize || pos + size + 2 > published)
+        {
+            // overwritten while reading, the check below throws it away
+            break;
+        }
+        out.push_back(slot(pos + 1));
+        for (std::size_t i = 0; i < size; i++)
+        {
+            out.push_back(slot(pos + 2 + i));
+        }
+        out.push_back(0);
+        pos += size + 2;
+    }
+
+    // if the writer reserved slots read above in the meantime, what was read can be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t reserved = m_reserved.load(std::memory_order_relaxed);
+    if (reserved - cursor > m_capacity)
+    {
+        out.resize(outStart);
+    }
+    cursor = published;
+}
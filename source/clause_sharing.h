@@ -0,0 +1,77 @@
+#ifndef CLAUSE_SHARING_H
+#define CLAUSE_SHARING_H
+
+#include "choice.h"
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief The ClauseSharing class - channel through which a solver exchanges learned clauses
+ * with solvers running in other threads
+ */
+class ClauseSharing
+{
+public:
+    virtual ~ClauseSharing() = default;
+
+    /**
+     * @brief exportClause - offers a learned clause to the other solvers
+     */
+    virtual void exportClause(const Clause& clause, unsigned lbd) = 0;
+
+    /**
+     * @brief importClauses - appends clauses exported by the other solvers since the last call,
+     * each one as its LBD followed by its literals and a 0
+     */
+    virtual void importClauses(std::vector<Literal>& out) = 0;
+};
+
+/**
+ * @brief The ExportRing class - lock-free ring buffer of clauses exported by one thread,
+ * which any number of other threads read.
+ *
+ * @details Every clause is written as its size, its LBD and its literals. The writer never
+ * waits for readers: a reader which falls more than a whole ring behind skips to the newest
+ * clauses and loses the ones in between, which is fine because sharing is only a hint.
+ * Positions grow forever and are taken modulo the capacity. The writer announces a position
+ * in m_reserved before overwriting it and in m_published after, so a reader can tell whether
+ * what it read could have been overwritten meanwhile (the same idea as a seqlock).
+ */
+class ExportRing
+{
+public:
+    ExportRing(std::size_t capacity = c_defaultCapacity);
+
+    /**
+     * @brief push - called only by the owning thread, clauses longer than c_maxClauseSize are dropped
+     */
+    void push(const Clause& clause, unsigned lbd);
+
+    /**
+     * @brief read - appends clauses published after cursor to out and moves cursor after them
+     * @param cursor - position of the reader, starts at 0
+     */
+    void read(std::uint64_t& cursor, std::vector<Literal>& out) const;
+
+    static const std::size_t c_defaultCapacity = 1 << 16;
+    static const std::size_t c_maxClauseSize = 64;
+
+private:
+    Literal slot(std::uint64_t pos) const
+    {
+        return m_data[pos % m_capacity].load(std::memory_order_relaxed);
+    }
+
+    std::size_t m_capacity;
+    std::unique_ptr<std::atomic<Literal>[]> m_data;
+
+    // end of the last clause that is being written and of the last one that is complete
+    std::atomic<std::uint64_t> m_reserved;
+    std::atomic<std::uint64_t> m_published;
+};
+
+#endif // CLAUSE_SHARING_H
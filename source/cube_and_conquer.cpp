@@ -0,0 +1,278 @@
+#include "cube_and_conquer.h"
+
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+const char* resultName(CubeResult result)
+{
+    switch (result)
+    {
+    case CubeResult::Sat:
+        return "SAT";
+    case CubeResult::Unsat:
+        return "UNSAT";
+    case CubeResult::Split:
+        return "SPLIT";
+    default:
+        return "STOPPED";
+    }
+}
+}
+
+CubeAndConquer::CubeAndConquer(const DimacsFormula& formula, unsigned threads, unsigned depth)
+    : m_formula(formula), m_threads(threads), m_depth(depth), m_pending(0), m_stop(false), m_steals(0)
+{
+    if (threads == 0)
+    {
+        throw std::runtime_error{"Cube and conquer needs at least one thread"};
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        m_queues.emplace_back(new WorkQueue());
+    }
+}
+
+CubeAndConquer::~CubeAndConquer() = default;
+
+void CubeAndConquer::generateCubes()
+{
+    Solver solver{m_formula};
+    std::vector<Cube> cubes(1);
+    for (unsigned depth = 0; depth < m_depth && !cubes.empty(); depth++)
+    {
+        std::vector<Cube> next;
+        for (Cube& cube : cubes)
+        {
+            Lookahead split = solver.lookahead(cube);
+            if (split.refuted)
+            {
+                m_refutedCubes++;
+            }
+            else if (split.branch == NullLiteral)
+            {
+                // everything is assigned, nothing to split on
+                next.push_back(std::move(cube));
+            }
+            else
+            {
+                next.push_back(cube);
+                next.back().push_back(split.branch);
+                cube.push_back(-split.branch);
+                next.push_back(std::move(cube));
+            }
+        }
+        cubes.swap(next);
+    }
+
+    m_generatedCubes = cubes.size();
+    for (std::size_t i = 0; i < cubes.size(); i++)
+    {
+        pushCube(i % m_threads, std::move(cubes[i]));
+    }
+}
+
+void CubeAndConquer::pushCube(unsigned index, Cube cube)
+{
+    m_pending++;
+    std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+    m_queues[index]->cubes.push_back(std::move(cube));
+}
+
+bool CubeAndConquer::takeCube(unsigned index, Cube& cube)
+{
+    {
+        WorkQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.cubes.empty())
+        {
+            cube = std::move(own.cubes.back());
+            own.cubes.pop_back();
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < m_threads; i++)
+    {
+        WorkQueue& victim = *m_queues[(index + i) % m_threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.cubes.empty())
+        {
+            cube = std::move(victim.cubes.front());
+            victim.cubes.pop_front();
+            m_steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CubeAndConquer::solveCube(unsigned index, Solver& solver, const Cube& cube)
+{
+    auto start = std::chrono::steady_clock::now();
+    const unsigned long long conflicts = solver.conflicts();
+
+    solver.setConflictLimit(ConflictLimit);
+    solver.solve(cube);
+
+    CubeStats stats;
+    stats.cube = cube;
+    stats.worker = index;
+
+    if (solver.status() == SolveResult::Unknown && !m_stop.load())
+    {
+        // the solver already learned something about the cube, so it picks the split
+        Lookahead split = solver.lookahead(cube);
+        if (split.refuted)
+        {
+            stats.result = CubeResult::Unsat;
+        }
+        else if (split.branch != NullLiteral)
+        {
+            stats.result = CubeResult::Split;
+            Cube positive = cube;
+            positive.push_back(split.branch);
+            pushCube(index, std::move(positive));
+            Cube negative = cube;
+            negative.push_back(-split.branch);
+            pushCube(index, std::move(negative));
+        }
+        else
+        {
+            // nothing left to split on, the cube has to be finished here
+            solver.setConflictLimit(0);
+            solver.solve(cube);
+            stats.result = answer(solver);
+        }
+    }
+    else
+    {
+        stats.result = answer(solver);
+    }
+
+    stats.conflicts = solver.conflicts() - conflicts;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record(std::move(stats));
+}
+
+CubeResult CubeAndConquer::answer(const Solver& solver)
+{
+    if (solver.status() == SolveResult::Unsat)
+    {
+        if (solver.failedAssumptions().empty())
+        {
+            // UNSAT without the cube, the other cubes needn't be solved
+            std::lock_guard<std::mutex> lock(m_resultMutex);
+            if (!m_stop.exchange(true))
+            {
+                m_result = SolveResult::Unsat;
+            }
+        }
+        return CubeResult::Unsat;
+    }
+    if (solver.status() == SolveResult::Unknown)
+    {
+        return CubeResult::Stopped;
+    }
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    if (!m_stop.exchange(true))
+    {
+        m_result = SolveResult::Sat;
+        m_solution.emplace(*solver.model());
+    }
+    return CubeResult::Sat;
+}
+
+void CubeAndConquer::record(CubeStats stats)
+{
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_cubeStats.push_back(std::move(stats));
+}
+
+void CubeAndConquer::runWorker(unsigned index)
+{
+    // one solver for all cubes of this worker; preprocessing is off, because it could
+    // eliminate variables which later cubes are made of
+    Solver solver{m_formula};
+    solver.UseLearning = true;
+    solver.UsePreprocessing = false;
+    solver.setTerminateFlag(&m_stop);
+
+    while (!m_stop.load())
+    {
+        Cube cube;
+        if (!takeCube(index, cube))
+        {
+            // other workers may still split their cubes
+            if (m_pending.load() == 0)
+            {
+                return;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        solveCube(index, solver, cube);
+        m_pending--;
+    }
+}
+
+SolveResult CubeAndConquer::solve()
+{
+    auto start = std::chrono::steady_clock::now();
+    generateCubes();
+    auto generated = std::chrono::steady_clock::now();
+    m_cubeSeconds = std::chrono::duration<double>(generated - start).count();
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < m_threads; i++)
+    {
+        workers.emplace_back(&CubeAndConquer::runWorker, this, i);
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    m_conquerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - generated).count();
+
+    // all cubes together cover the whole formula, so if none of them is SAT the formula isn't
+    if (m_result == SolveResult::Unknown && !m_stop.load())
+    {
+        m_result = SolveResult::Unsat;
+    }
+    return m_result;
+}
+
+void CubeAndConquer::writeCsv(std::ostream& out) const
+{
+    out << "cube,depth,worker,seconds,conflicts,result\n";
+    for (const CubeStats& stats : m_cubeStats)
+    {
+        for (std::size_t i = 0; i < stats.cube.size(); i++)
+        {
+            out << (i ? " " : "") << stats.cube[i];
+        }
+        out << "," << stats.cube.size() << "," << stats.worker << "," << stats.seconds
+            << "," << stats.conflicts << "," << resultName(stats.result) << "\n";
+    }
+}
+
+std::string CubeAndConquer::getInfo() const
+{
+    std::size_t counts[4] = {0, 0, 0, 0};
+    for (const CubeStats& stats : m_cubeStats)
+    {
+        counts[static_cast<int>(stats.result)]++;
+    }
+
+    std::ostringstream info;
+    info << "Cubes: " << m_generatedCubes << " generated at depth " << m_depth << ", "
+         << m_refutedCubes << " refuted by lookahead, in " << m_cubeSeconds << " s\n";
+    info << "Conquer: " << m_threads << " workers, " << counts[static_cast<int>(CubeResult::Unsat)]
+         << " UNSAT, " << counts[static_cast<int>(CubeResult::Split)] << " split, "
+         << counts[static_cast<int>(CubeResult::Sat)] << " SAT, " << m_steals.load()
+         << " steals, in " << m_conquerSeconds << " s";
+    return info.str();
+}
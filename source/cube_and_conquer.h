@@ -0,0 +1,152 @@
+#ifndef CUBE_AND_CONQUER_H
+#define CUBE_AND_CONQUER_H
+
+#include "solver.h"
+#include "dimacs_parser.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+using Cube = std::vector<Literal>;
+
+/**
+ * @brief The CubeResult enum - how the work on one cube ended
+ */
+enum class CubeResult
+{
+    Sat,
+    Unsat,
+    // the conflict limit was hit and the cube was split in two
+    Split,
+    // another cube was SAT first
+    Stopped
+};
+
+/**
+ * @brief The CubeStats struct - one attempt to solve a cube, for tuning the split depth
+ */
+struct CubeStats
+{
+    Cube cube;
+    unsigned worker = 0;
+    double seconds = 0;
+    unsigned long long conflicts = 0;
+    CubeResult result = CubeResult::Stopped;
+};
+
+/**
+ * @brief The CubeAndConquer class - splits the formula into cubes with lookahead and solves
+ * them in parallel.
+ *
+ * @details The cube phase splits the formula recursively up to the given depth, every split on
+ * the variable chosen by Solver::lookahead. Cubes refuted by the lookahead itself are dropped.
+ *
+ * In the conquer phase every worker thread has its own deque of cubes. It takes cubes from the
+ * back of its own deque and, when that is empty, steals from the front of the others, where
+ * the cubes closest to the root (the biggest ones) are. Every worker has one Solver for all
+ * of its cubes, which it solves with the cube literals as assumptions, so clauses learned on
+ * one cube help with the next ones. A cube that isn't solved within ConflictLimit conflicts
+ * is split again with lookahead on the worker's solver and both halves go back to the
+ * worker's deque. The formula is UNSAT when all cubes are, or when a solver finds it UNSAT
+ * without the assumptions; the first SAT cube stops all workers.
+ */
+class CubeAndConquer
+{
+public:
+    /**
+     * @param formula - must stay alive and unchanged while solve runs
+     * @param threads - number of workers, at least one
+     * @param depth - how many times the formula is split before solving, giving up to 2^depth cubes
+     */
+    CubeAndConquer(const DimacsFormula& formula, unsigned threads, unsigned depth);
+
+    ~CubeAndConquer();
+
+    /**
+     * @brief ConflictLimit - conflicts after which an unsolved cube is split again
+     */
+    unsigned long long ConflictLimit = 20000;
+
+    SolveResult solve();
+
+    /**
+     * @brief solution - model found for the SAT cube, if the formula is SAT
+     */
+    const OptionalPartialValuation& solution() const
+    {
+        return m_solution;
+    }
+
+    const std::vector<CubeStats>& cubeStats() const
+    {
+        return m_cubeStats;
+    }
+
+    /**
+     * @brief writeCsv - one line per solved, split or stopped cube
+     */
+    void writeCsv(std::ostream& out) const;
+
+    std::string getInfo() const;
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Cube> cubes;
+    };
+
+    /**
+     * @brief generateCubes - the cube phase, fills the work queues round-robin
+     */
+    void generateCubes();
+
+    void runWorker(unsigned index);
+
+    /**
+     * @brief takeCube - newest cube of the worker's own queue, or the oldest one stolen from another
+     */
+    bool takeCube(unsigned index, Cube& cube);
+
+    void pushCube(unsigned index, Cube cube);
+
+    /**
+     * @brief solveCube - solves the cube with the worker's solver, or splits it if it takes too long
+     */
+    void solveCube(unsigned index, Solver& solver, const Cube& cube);
+
+    /**
+     * @brief answer - records the model if the solver found one first, or that the formula
+     * is UNSAT if the solver found it without the cube
+     */
+    CubeResult answer(const Solver& solver);
+
+    void record(CubeStats stats);
+
+    const DimacsFormula& m_formula;
+    unsigned m_threads;
+    unsigned m_depth;
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    // cubes queued or being solved, all work is done when it drops to 0
+    std::atomic<std::size_t> m_pending;
+    std::atomic<bool> m_stop;
+
+    std::mutex m_resultMutex;
+    SolveResult m_result = SolveResult::Unknown;
+    OptionalPartialValuation m_solution;
+    std::vector<CubeStats> m_cubeStats;
+
+    std::size_t m_generatedCubes = 0;
+    std::size_t m_refutedCubes = 0;
+    std::atomic<unsigned long long> m_steals;
+    double m_cubeSeconds = 0;
+    double m_conquerSeconds = 0;
+};
+
+#endif // CUBE_AND_CONQUER_H
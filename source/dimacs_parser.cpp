@@ -0,0 +1,279 @@
+#include "dimacs_parser.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define DIMACS_HAS_MMAP
+#endif
+
+void DimacsParser::parse(std::istream& in, DimacsFormula& formula)
+{
+    m_stream = &in;
+    m_pos = m_end = m_buffer.data();
+    m_bytes = 0;
+    parseInput(formula);
+    m_stream = nullptr;
+}
+
+void DimacsParser::parseFile(const std::string& path, DimacsFormula& formula)
+{
+#ifdef DIMACS_HAS_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        std::size_t length = info.st_size;
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped != MAP_FAILED)
+        {
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            m_stream = nullptr;
+            m_pos = static_cast<const char*>(mapped);
+            m_end = m_pos + length;
+            m_bytes = length;
+            try
+            {
+                parseInput(formula);
+            }
+            catch (...)
+            {
+                munmap(mapped, length);
+                throw;
+            }
+            munmap(mapped, length);
+            return;
+        }
+    }
+    else if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+    // no mmap on this system, or the file can't be mapped (e.g. it's a pipe)
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+    {
+        throw std::runtime_error{"Can't open " + path};
+    }
+    parse(in, formula);
+}
+
+bool DimacsParser::refill()
+{
+    if (m_stream == nullptr || !*m_stream)
+    {
+        return false;
+    }
+    m_stream->read(m_buffer.data(), m_buffer.size());
+    std::size_t count = m_stream->gcount();
+    m_pos = m_buffer.data();
+    m_end = m_pos + count;
+    m_bytes += count;
+    return count > 0;
+}
+
+void DimacsParser::skipLine()
+{
+    int c;
+    while ((c = peek()) != c_end)
+    {
+        m_pos++;
+        if (c == '\n')
+        {
+            return;
+        }
+    }
+}
+
+void DimacsParser::skipWhitespace()
+{
+    int c;
+    while ((c = peek()) == ' ' || (c >= '\t' && c <= '\r'))
+    {
+        m_pos++;
+    }
+}
+
+long long DimacsParser::readInteger()
+{
+    skipWhitespace();
+    bool negative = false;
+    int c = peek();
+    if (c == '-' || c == '+')
+    {
+        negative = c == '-';
+        m_pos++;
+        c = peek();
+    }
+    if (c < '0' || c > '9')
+    {
+        throw std::runtime_error{DimacsWrongFormat};
+    }
+
+    long long value = 0;
+    do
+    {
+        value = value * 10 + (c - '0');
+        if (value > std::numeric_limits<Literal>::max())
+        {
+            throw std::runtime_error{DimacsWrongFormat};
+        }
+        m_pos++;
+        c = peek();
+    } while (c >= '0' && c <= '9');
+
+    return negative ? -value : value;
+}
+
+void DimacsParser::parseInput(DimacsFormula& formula)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    formula.varCount = 0;
+    formula.literals.clear();
+    formula.clauseCount = 0;
+    formula.stats = LoadStats();
+    m_clause.clear();
+
+    // comments and the problem line
+    bool hasProblemLine = false;
+    while (!hasProblemLine)
+    {
+        skipWhitespace();
+        int c = peek();
+        if (c == 'c')
+        {
+            skipLine();
+        }
+        else if (c == 'p')
+        {
+            m_pos++;
+            skipWhitespace();
+            for (char expected : {'c', 'n', 'f'})
+            {
+                if (peek() != expected)
+                {
+                    throw std::runtime_error{DimacsWrongFormat};
+                }
+                m_pos++;
+            }
+            long long varCount = readInteger();
+            long long clauseCount = readInteger();
+            if (varCount < 0 || clauseCount < 0)
+            {
+                throw std::runtime_error{DimacsWrongFormat};
+            }
+            if (varCount > c_maxVariable)
+            {
+                throw std::runtime_error{"Too many variables: " + std::to_string(varCount) +
+                            ", at most " + std::to_string(c_maxVariable) + " are supported"};
+            }
+            formula.varCount = varCount;
+            // the header may lie, but every literal takes at least two bytes of the input;
+            // a stream is only known up to the end of the buffer
+            std::size_t inputBytes = m_stream ? m_buffer.size() : m_end - m_pos;
+            formula.literals.reserve(std::min<std::size_t>(clauseCount * 4, inputBytes / 2));
+            hasProblemLine = true;
+        }
+        else
+        {
+            throw std::runtime_error{DimacsWrongFormat};
+        }
+    }
+
+    // every literal gets a stamp, the stamp of a clause is bigger than of all the previous ones
+    m_litStamps.assign(2 * (formula.varCount + 1), 0);
+    m_stamp = 0;
+
+    // clauses, which may span several lines and be interleaved with comments
+    while (true)
+    {
+        skipWhitespace();
+        int c = peek();
+        if (c == c_end)
+        {
+            break;
+        }
+        if (c == '%')
+        {
+            // ends the formula in some of the old benchmark files
+            break;
+        }
+        if (c == 'c')
+        {
+            skipLine();
+            continue;
+        }
+
+        long long lit = readInteger();
+        if (lit == 0)
+        {
+            addClause(formula);
+        }
+        else if (std::abs(lit) > formula.varCount)
+        {
+            throw std::runtime_error{"Variable " + std::to_string(std::abs(lit)) +
+                        " is out of range of the problem line"};
+        }
+        else
+        {
+            m_clause.push_back(static_cast<Literal>(lit));
+        }
+    }
+    // the last clause doesn't have to be terminated
+    if (!m_clause.empty())
+    {
+        addClause(formula);
+    }
+
+    formula.stats.bytes = m_bytes;
+    formula.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void DimacsParser::addClause(DimacsFormula& formula)
+{
+    if (++m_stamp == 0)
+    {
+        std::fill(m_litStamps.begin(), m_litStamps.end(), 0);
+        m_stamp = 1;
+    }
+
+    std::size_t clauseStart = formula.literals.size();
+    bool tautology = false;
+    for (Literal lit : m_clause)
+    {
+        if (m_litStamps[litIndex(-lit)] == m_stamp)
+        {
+            tautology = true;
+            break;
+        }
+        if (m_litStamps[litIndex(lit)] == m_stamp)
+        {
+            formula.stats.removedDuplicates++;
+            continue;
+        }
+        m_litStamps[litIndex(lit)] = m_stamp;
+        formula.literals.push_back(lit);
+    }
+    m_clause.clear();
+
+    if (tautology)
+    {
+        // always true, the solver doesn't need to see it
+        formula.literals.resize(clauseStart);
+        formula.stats.removedTautologies++;
+        return;
+    }
+    formula.literals.push_back(0);
+    formula.clauseCount++;
+}
@@ -0,0 +1,117 @@
+#ifndef DIMACS_PARSER_H
+#define DIMACS_PARSER_H
+
+#include "choice.h"
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <cstddef>
+
+/**
+ * @brief The LoadStats struct - how long loading a formula took and what was removed from it
+ */
+struct LoadStats
+{
+    std::size_t bytes = 0;
+    double seconds = 0;
+    std::size_t removedDuplicates = 0;
+    std::size_t removedTautologies = 0;
+
+    double megabytesPerSecond() const
+    {
+        return seconds > 0 ? bytes / seconds / 1e6 : 0;
+    }
+};
+
+/**
+ * @brief The DimacsFormula struct - CNF formula as it was read from a DIMACS file
+ */
+struct DimacsFormula
+{
+    unsigned varCount = 0;
+
+    /**
+     * @brief literals - all clauses one after another, each of them terminated by 0
+     */
+    std::vector<Literal> literals;
+
+    std::size_t clauseCount = 0;
+
+    LoadStats stats;
+};
+
+/**
+ * @brief The DimacsParser class - reads CNF formulas in DIMACS format.
+ *
+ * @details Input is read through a large buffer (or memory mapped, when reading a file) and
+ * numbers are scanned by hand, so clauses may span lines. Duplicate literals are removed and
+ * tautologies are dropped while loading. Buffers are kept between calls, so one parser can
+ * load many files without reallocating.
+ */
+class DimacsParser
+{
+public:
+    DimacsParser(std::size_t bufferSize = c_defaultBufferSize) : m_buffer(bufferSize)
+    {
+    }
+
+    /**
+     * @brief parse - reads the whole stream into formula, overwriting what was in it
+     * @throws std::runtime_error if the input isn't valid DIMACS
+     */
+    void parse(std::istream& in, DimacsFormula& formula);
+
+    /**
+     * @brief parseFile - like parse, but maps the file into memory when the system supports it
+     */
+    void parseFile(const std::string& path, DimacsFormula& formula);
+
+    static const std::size_t c_defaultBufferSize = 1 << 20;
+
+private:
+    static const int c_end = -1;
+
+    /**
+     * @brief parseInput - parses everything between m_pos and m_end, refilling from m_stream
+     */
+    void parseInput(DimacsFormula& formula);
+
+    /**
+     * @brief addClause - normalizes m_clause and appends it to the formula
+     */
+    void addClause(DimacsFormula& formula);
+
+    bool refill();
+
+    int peek()
+    {
+        if (m_pos == m_end && !refill())
+        {
+            return c_end;
+        }
+        return static_cast<unsigned char>(*m_pos);
+    }
+
+    void skipLine();
+
+    void skipWhitespace();
+
+    long long readInteger();
+
+    const std::string DimacsWrongFormat = "Wrong input format of DIMACS stream";
+
+    std::vector<char> m_buffer;
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    std::istream* m_stream = nullptr;
+    std::size_t m_bytes = 0;
+
+    Clause m_clause;
+
+    // per literal (litIndex) stamp of the last clause that contained it
+    std::vector<unsigned> m_litStamps;
+    unsigned m_stamp = 0;
+};
+
+#endif // DIMACS_PARSER_H
@@ -0,0 +1,143 @@
+#include "literal_scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+// the vector paths are compiled with target attributes, so the rest of the program
+// doesn't need -mavx2 and still runs on CPUs without it
+#define LITERAL_SCAN_HAS_X86
+#endif
+
+namespace
+{
+
+using ScanFunction = int (*)(const Literal*, unsigned, unsigned, const Tribool*);
+
+int scanScalar(const Literal* literals, unsigned start, unsigned size, const Tribool* values)
+{
+    for (unsigned j = start; j < size; j++)
+    {
+        if (values[litIndex(literals[j])] != Tribool::False)
+        {
+            return j;
+        }
+    }
+    return -1;
+}
+
+#ifdef LITERAL_SCAN_HAS_X86
+
+__attribute__((target("sse4.1")))
+int scanSse41(const Literal* literals, unsigned start, unsigned size, const Tribool* values)
+{
+    unsigned j = start;
+    for (; j + 4 <= size; j += 4)
+    {
+        // litIndex of 4 literals: 2*|l| + sign bit
+        __m128i lits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(literals + j));
+        __m128i index = _mm_add_epi32(_mm_slli_epi32(_mm_abs_epi32(lits), 1), _mm_srli_epi32(lits, 31));
+        __m128i value = _mm_setr_epi32(static_cast<int>(values[_mm_extract_epi32(index, 0)]),
+                                       static_cast<int>(values[_mm_extract_epi32(index, 1)]),
+                                       static_cast<int>(values[_mm_extract_epi32(index, 2)]),
+                                       static_cast<int>(values[_mm_extract_epi32(index, 3)]));
+        __m128i isFalse = _mm_cmpeq_epi32(value, _mm_set1_epi32(static_cast<int>(Tribool::False)));
+        int notFalse = ~_mm_movemask_ps(_mm_castsi128_ps(isFalse)) & 0xF;
+        if (notFalse)
+        {
+            return j + __builtin_ctz(notFalse);
+        }
+    }
+    return scanScalar(literals, j, size, values);
+}
+
+__attribute__((target("avx2")))
+int scanAvx2(const Literal* literals, unsigned start, unsigned size, const Tribool* values)
+{
+    const int* words = reinterpret_cast<const int*>(values);
+    unsigned j = start;
+    for (; j + 8 <= size; j += 8)
+    {
+        __m256i lits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(literals + j));
+        __m256i index = _mm256_add_epi32(_mm256_slli_epi32(_mm256_abs_epi32(lits), 1), _mm256_srli_epi32(lits, 31));
+        // every value is read with the 3 bytes after it, which are masked out
+        __m256i value = _mm256_and_si256(_mm256_i32gather_epi32(words, index, 1), _mm256_set1_epi32(0xFF));
+        __m256i isFalse = _mm256_cmpeq_epi32(value, _mm256_set1_epi32(static_cast<int>(Tribool::False)));
+        int notFalse = ~_mm256_movemask_ps(_mm256_castsi256_ps(isFalse)) & 0xFF;
+        if (notFalse)
+        {
+            return j + __builtin_ctz(notFalse);
+        }
+    }
+    return scanScalar(literals, j, size, values);
+}
+
+#endif
+
+ScanFunction scanFunction(ScanPath path)
+{
+    switch (path)
+    {
+#ifdef LITERAL_SCAN_HAS_X86
+    case ScanPath::Avx2:
+        return scanAvx2;
+    case ScanPath::Sse41:
+        return scanSse41;
+#endif
+    default:
+        return scanScalar;
+    }
+}
+
+// chosen once, when the program starts
+const ScanFunction c_bestScan = scanFunction(supportedScanPath());
+
+}
+
+bool isScanPathSupported(ScanPath path)
+{
+#ifdef LITERAL_SCAN_HAS_X86
+    // this can run during static initialization, before libgcc has detected the CPU
+    __builtin_cpu_init();
+#endif
+    switch (path)
+    {
+#ifdef LITERAL_SCAN_HAS_X86
+    case ScanPath::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case ScanPath::Sse41:
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    case ScanPath::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ScanPath supportedScanPath()
+{
+    // the SSE4.1 path isn't faster than the scalar one without a gather, see bench --scan
+    return isScanPathSupported(ScanPath::Avx2) ? ScanPath::Avx2 : ScanPath::Scalar;
+}
+
+const char* scanPathName(ScanPath path)
+{
+    switch (path)
+    {
+    case ScanPath::Avx2:
+        return "avx2";
+    case ScanPath::Sse41:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
+
+int firstNonFalse(const Literal* literals, unsigned start, unsigned size, const Tribool* values)
+{
+    return c_bestScan(literals, start, size, values);
+}
+
+int firstNonFalse(ScanPath path, const Literal* literals, unsigned start, unsigned size, const Tribool* values)
+{
+    return scanFunction(path)(literals, start, size, values);
+}
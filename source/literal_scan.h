@@ -0,0 +1,49 @@
+#ifndef LITERAL_SCAN_H
+#define LITERAL_SCAN_H
+
+#include "choice.h"
+
+/**
+ * @brief The ScanPath enum - implementations of firstNonFalse, the best one the CPU supports is used
+ */
+enum class ScanPath
+{
+    Scalar,
+    // 4 literal indices at a time, values are still loaded one by one (no gather before AVX2)
+    Sse41,
+    // 8 literals at a time, values are gathered
+    Avx2
+};
+
+/**
+ * @brief c_scanPadding - number of readable bytes which have to follow the last literal value,
+ * the AVX2 path reads every value as a 4 byte word
+ */
+const unsigned c_scanPadding = 3;
+
+/**
+ * @brief firstNonFalse - position of the first literal in [start, size) which isn't false
+ * @param literals - literals of a clause
+ * @param values - value of every literal, indexed by litIndex, followed by c_scanPadding bytes
+ * @return the position, or -1 if all of those literals are false
+ */
+int firstNonFalse(const Literal* literals, unsigned start, unsigned size, const Tribool* values);
+
+/**
+ * @brief firstNonFalse - the same, with the given implementation, for testing and benchmarks
+ */
+int firstNonFalse(ScanPath path, const Literal* literals, unsigned start, unsigned size, const Tribool* values);
+
+/**
+ * @brief supportedScanPath - the fastest implementation which the CPU supports, used by firstNonFalse
+ */
+ScanPath supportedScanPath();
+
+/**
+ * @brief isScanPathSupported - whether the CPU can run the implementation
+ */
+bool isScanPathSupported(ScanPath path);
+
+const char* scanPathName(ScanPath path);
+
+#endif // LITERAL_SCAN_H
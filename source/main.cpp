@@ -1,102 +1,189 @@
 #include "solver.h"
+#include "portfolio.h"
+#include "cube_and_conquer.h"
+#include "batch.h"
 
 #include <fstream>
 #include <stdexcept>
 #include <string>
-#include <limits.h>
-#include <unistd.h>
 #include <chrono>
 #include <ctime>
+#include <thread>
+#include <algorithm>
+#include <memory>
 
 using std::chrono::high_resolution_clock;
 using time_point = std::chrono::high_resolution_clock::time_point;
 
-void testWithTimer(std::string fileName, bool useLearning);
+/**
+ * @brief runSolver - solves the file with one solver and prints its statistics
+ * @param proofPath - if not empty, a DRAT proof is written there
+ */
+int runSolver(const std::string& path, const std::string& proofPath = "", ProofFormat format = ProofFormat::Binary);
+
+/**
+ * @brief runPortfolio - solves the file with the given number of parallel workers
+ */
+int runPortfolio(const std::string& path, unsigned threads);
+
+/**
+ * @brief runCubeAndConquer - solves the file by splitting it into cubes, timing of every cube
+ * is written to path.cubes.csv
+ */
+int runCubeAndConquer(const std::string& path, unsigned threads, unsigned depth);
+
+/**
+ * @brief runBatch - solves all CNF files of a directory or a list file in one process,
+ * CSV lines go to stdout and the summary to stderr
+ */
+int runBatch(const std::string& input, unsigned threads, const SolveBudget& budget);
 
 int main(int argc, char **argv)
 {
-    std::ifstream dimacsStream;
-    if (2 != argc)
+    try
     {
-        std::vector<std::string> tests {"plsWrk.cnf", "test-SAT.cnf", "test-UNSAT.cnf", "sat.cnf", "unsat.cnf", "sudoku.cnf"};
-        std::vector<bool> expected {true, true, false, true, false, true};
-        // run tests
-        std::cout << "----------------------------------------------------------\n";
-        std::cout << "     Running tests with two-watched-literals:\n";
-        std::cout << "----------------------------------------------------------\n";
-        for (unsigned i = 0; i < tests.size() - 1; i++)
+        if (argc >= 3 && argc <= 6 && std::string(argv[1]) == "--batch")
         {
-            std::string str = tests[i];
-            dimacsStream = std::ifstream{"../source/" + str};
-
-            Solver t{dimacsStream};
-            t.UseLearning = true;
-            OptionalPartialValuation solution = t.solve2();
-            dimacsStream.close();
-
-            if (solution.operator bool() == expected[i])
-            {
-                std::cout << "test #" << i << "passed" << std::endl;
-            }
-            else
-            {
-                std::cout << "test #" << i << "failed" << std::endl;
-            }
+            unsigned threads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+            SolveBudget budget;
+            budget.conflicts = argc > 4 ? std::stoull(argv[4]) : 0;
+            budget.seconds = argc > 5 ? std::stod(argv[5]) : 0;
+            return runBatch(argv[2], threads, budget);
+        }
+        if (4 == argc && (std::string(argv[2]) == "--proof" || std::string(argv[2]) == "--text-proof"))
+        {
+            return runSolver(argv[1], argv[3], std::string(argv[2]) == "--proof" ? ProofFormat::Binary : ProofFormat::Text);
+        }
+        if (2 == argc)
+        {
+            return runSolver(argv[1]);
+        }
+        if (3 == argc)
+        {
+            return runPortfolio(argv[1], std::stoul(argv[2]));
+        }
+        if (4 == argc)
+        {
+            return runCubeAndConquer(argv[1], std::stoul(argv[2]), std::stoul(argv[3]));
         }
-        std::cout << "\n\n";
-        const unsigned runWhich = tests.size()-1;
-        dimacsStream = std::ifstream{"../source/" + tests[runWhich]};
-    }
-    else
-    {
-        dimacsStream = std::ifstream{argv[1]};
     }
-
-    if (!dimacsStream)
+    catch (const std::exception& error)
     {
-        throw std::runtime_error{"Bad path to dimacs file"};
+        // e.g. a file which isn't valid DIMACS or is too large
+        std::cerr << argv[0] << ": " << error.what() << std::endl;
+        return 1;
     }
 
-    testWithTimer("sudoku.cnf", true);
-    testWithTimer("sudoku.cnf", false);
-
-    return 0;
+    // timing of the bundled and generated instances is done by the bench target
+    std::cerr << "usage: " << argv[0] << " file.cnf [threads [cube depth]]" << std::endl;
+    std::cerr << "       " << argv[0] << " file.cnf --proof|--text-proof proof.drat" << std::endl;
+    std::cerr << "       " << argv[0] << " --batch directory|list [threads [conflict limit [seconds]]]" << std::endl;
+    return 1;
 }
 
-void testWithTimer(std::string fileName, bool useLearning)
+int runSolver(const std::string& path, const std::string& proofPath, ProofFormat format)
 {
-    std::string fName = fileName + (useLearning ? " with " : " without ");
-    std::ifstream dimacsStream = std::ifstream{"../source/" + fileName};
+    DimacsFormula formula;
+    DimacsParser{}.parseFile(path, formula);
 
-    std::cout << "----------------------------------------------------------\n";
-    std::cout << "     Running " << fName << "two-watched-literals:\n";
-    std::cout << "----------------------------------------------------------\n";
+    std::ofstream proofFile;
+    std::unique_ptr<ProofWriter> proof;
+    if (!proofPath.empty())
+    {
+        proofFile.open(proofPath, std::ios::binary);
+        if (!proofFile)
+        {
+            throw std::runtime_error{"Can't open " + proofPath};
+        }
+        // writing is left to a thread only if it won't take the core from the solver
+        proof.reset(new ProofWriter(proofFile, format, std::thread::hardware_concurrency() > 1));
+    }
 
     time_point startTime = high_resolution_clock::now();
     std::clock_t c_start = std::clock();
 
-    Solver s{dimacsStream};
-    s.UseLearning = true;
-    OptionalPartialValuation solution = useLearning ? s.solve2() : s.solve();
+    Solver s{formula};
+    s.setProgressOutput(&std::cout);
+    s.setProofWriter(proof.get());
+    OptionalPartialValuation solution = s.solve2();
+    if (proof)
+    {
+        proof->finish();
+    }
 
     std::clock_t c_end = std::clock();
     time_point finishTime = high_resolution_clock::now();
-    dimacsStream.close();
 
-    if (solution)
+    std::cout << (solution ? "SAT" : "UNSAT") << std::endl;
+    std::cout << s.getInfo() << std::endl;
+    std::cout << s.getJson() << std::endl;
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finishTime - startTime).count();
+    long double time_elapsed_ms = 1000.0 * (c_end-c_start) / CLOCKS_PER_SEC;
+    std::cout << "CPU time used: " << time_elapsed_ms  << " ms" << std::endl;
+    std::cout << "Total time elapsed = " << duration / 1000.0 << " ms" << std::endl;
+    if (proof)
+    {
+        std::cout << "Proof: " << proof->additions() << " added and " << proof->deletions()
+                  << " deleted clauses, " << proof->bytes() << " bytes" << std::endl;
+    }
+    return 0;
+}
+
+int runPortfolio(const std::string& path, unsigned threads)
+{
+    DimacsFormula formula;
+    DimacsParser{}.parseFile(path, formula);
+
+    time_point startTime = high_resolution_clock::now();
+    Portfolio portfolio{formula, threads};
+    SolveResult result = portfolio.solve();
+    time_point finishTime = high_resolution_clock::now();
+
+    if (result == SolveResult::Sat)
     {
         std::cout << "SAT" << std::endl;
-//        std::cout << solution.value() << std::endl;
     }
-    else
+    else if (result == SolveResult::Unsat)
     {
         std::cout << "UNSAT" << std::endl;
     }
+    else
+    {
+        std::cout << "UNKNOWN" << std::endl;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finishTime - startTime).count();
+    std::cout << "Winner: worker " << portfolio.winner() << " of " << threads << std::endl;
+    std::cout << "Total time elapsed = " << duration / 1000.0 << " ms" << std::endl;
+    return 0;
+}
+
+int runCubeAndConquer(const std::string& path, unsigned threads, unsigned depth)
+{
+    DimacsFormula formula;
+    DimacsParser{}.parseFile(path, formula);
+
+    time_point startTime = high_resolution_clock::now();
+    CubeAndConquer cubeAndConquer{formula, threads, depth};
+    SolveResult result = cubeAndConquer.solve();
+    time_point finishTime = high_resolution_clock::now();
+
+    std::cout << (result == SolveResult::Sat ? "SAT" : result == SolveResult::Unsat ? "UNSAT" : "UNKNOWN") << std::endl;
+    std::cout << cubeAndConquer.getInfo() << std::endl;
+
+    std::ofstream csv{path + ".cubes.csv"};
+    cubeAndConquer.writeCsv(csv);
 
-//    std::cout << s.getInfo() << std::endl;
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finishTime - startTime).count();
-    long double time_elapsed_ms = 1000.0 * (c_end-c_start) / CLOCKS_PER_SEC;
-    std::cout << "CPU time used: " << time_elapsed_ms  << " ms" << std::endl;
     std::cout << "Total time elapsed = " << duration / 1000.0 << " ms" << std::endl;
-    std::cout << "\n\n";
+    return 0;
+}
+
+int runBatch(const std::string& input, unsigned threads, const SolveBudget& budget)
+{
+    BatchSolver batch{BatchSolver::listInputs(input), threads};
+    batch.Budget = budget;
+    batch.run(std::cout);
+    std::cerr << batch.getInfo() << std::endl;
+    return batch.errors() ? 1 : 0;
 }
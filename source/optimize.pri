@@ -0,0 +1,28 @@
+# Optimization settings shared by CDCL.pro and bench.pro, included after TARGET is set.
+
+# Release builds use -O3 and link-time optimization, which lets the propagation loop
+# inline across partial_valuation.cpp, clause_arena.cpp and solver.cpp.
+# CONFIG+=no_lto keeps the plain -O2 build, pgo.sh compares against it.
+CONFIG(release, debug|release):!no_lto {
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS_RELEASE += -O3 -flto
+    QMAKE_LFLAGS_RELEASE += -O3 -flto
+}
+
+# Two stage profile-guided build, driven by pgo.sh:
+#   CONFIG+=pgo_generate - instrumented TARGET_pgo_gen, which writes profiles to PGO_DIR
+#   CONFIG+=pgo_use      - TARGET_pgo, optimized with the profiles from PGO_DIR
+# Both stages have to be built in the same directory, profiles are matched by object file paths.
+isEmpty(PGO_DIR): PGO_DIR = $$OUT_PWD/pgo-profile
+
+pgo_generate {
+    TARGET = $${TARGET}_pgo_gen
+    QMAKE_CXXFLAGS += -fprofile-generate=$$PGO_DIR
+    QMAKE_LFLAGS += -fprofile-generate=$$PGO_DIR
+}
+
+pgo_use {
+    TARGET = $${TARGET}_pgo
+    QMAKE_CXXFLAGS += -fprofile-use=$$PGO_DIR -fprofile-correction
+    QMAKE_LFLAGS += -fprofile-use=$$PGO_DIR -fprofile-correction
+}
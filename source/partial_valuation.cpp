@@ -1,31 +1,49 @@
 #include "partial_valuation.h"
+#include "literal_scan.h"
 
 #include <algorithm>
 #include <cstdlib>
 
 PartialValuation::PartialValuation(unsigned nVars)
-    : m_values(nVars+1, c_defaultLiteralInfo),
+    : m_litValues(2 * (nVars+1) + c_scanPadding, Tribool::Undefined),
+    m_levels(nVars+1, 0),
+    m_reasons(nVars+1, NullClause),
+    m_order(nVars),
+    m_eliminated(nVars+1, 0),
+    m_savedPhase(nVars+1, Tribool::True),
+    m_targetPhase(nVars+1, Tribool::Undefined),
+    m_bestPhase(nVars+1, Tribool::Undefined),
+    m_targetSize(0),
+    m_bestSize(0),
+    m_useTargetPhase(true),
     m_stack()
 {
     m_stack.reserve(nVars * c_stackSizeMultiplier);
 }
 
-void PartialValuation::ClearVariable(Literal l)
+void PartialValuation::ClearVariable(Literal l, bool savePhase)
 {
     unsigned pos = std::abs(l);
-    m_values[pos].level = 0;
-    m_values[pos].value = Tribool::Undefined;
+    if (savePhase)
+    {
+        m_savedPhase[pos] = l > 0 ? Tribool::True : Tribool::False;
+    }
+    m_levels[pos] = 0;
+    m_litValues[2 * pos] = Tribool::Undefined;
+    m_litValues[2 * pos + 1] = Tribool::Undefined;
+    m_reasons[pos] = NullClause;
+    m_order.insert(pos);
 }
 
 void PartialValuation::pop()
 {
-    Choice c = m_stack.back();
-    if (c.isDecided)
+    // levels which start at the popped literal (or are empty) end with it
+    while (!m_trailLim.empty() && m_trailLim.back() + 1 >= m_stack.size())
     {
-        decides.erase(std::remove(decides.begin(), decides.end(), c.lit), decides.end());
+        m_trailLim.pop_back();
     }
 
-    ClearVariable(c.lit);
+    ClearVariable(m_stack.back());
     m_stack.pop_back();
 }
 
@@ -34,43 +52,84 @@ unsigned PartialValuation::stackSize() const
     return m_stack.size();
 }
 
-Choice& PartialValuation::back() const
+void PartialValuation::bumpWeight(Literal l)
 {
-    return const_cast<Choice&>(m_stack.back());
+    m_order.bump(std::abs(l));
 }
 
-void PartialValuation::updateWeights(Clause& c)
+void PartialValuation::updateWeights()
 {
-    for (Literal l : c)
+    m_order.decay();
+}
+
+Literal PartialValuation::decideHeuristic()
+{
+    // Variable State Independent Decaying Sum
+    // assigned and eliminated variables are removed lazily, assigned ones come back on ClearVariable
+    while (!m_order.empty())
     {
-        m_values[std::abs(l)].weight += 1;
+        unsigned candidatePos = m_order.removeMax();
+        if (m_litValues[2 * candidatePos] == Tribool::Undefined && !m_eliminated[candidatePos])
+        {
+            Tribool phase = m_savedPhase[candidatePos];
+            if (m_useTargetPhase && m_targetPhase[candidatePos] != Tribool::Undefined)
+            {
+                phase = m_targetPhase[candidatePos];
+            }
+            return phase == Tribool::False ? -static_cast<Literal>(candidatePos) : candidatePos;
+        }
     }
+    return NullLiteral;
 }
 
-void PartialValuation::updateWeights()
+void PartialValuation::updateTargetPhases()
 {
-    std::for_each(m_values.begin(), m_values.end(),
-        [divideWeightsBy = divideWeightsBy] (LiteralInfo& f)
+    // literals from the current level are the ones in conflict
+    unsigned consistent = m_trailLim.empty() ? m_stack.size() : m_trailLim.back();
+
+    if (consistent > m_targetSize)
+    {
+        m_targetSize = consistent;
+        for (unsigned i = 0; i < consistent; i++)
+        {
+            m_targetPhase[std::abs(m_stack[i])] = m_stack[i] > 0 ? Tribool::True : Tribool::False;
+        }
+    }
+    if (consistent > m_bestSize)
+    {
+        m_bestSize = consistent;
+        for (unsigned i = 0; i < consistent; i++)
         {
-            f.weight = f.weight / divideWeightsBy;
+            m_bestPhase[std::abs(m_stack[i])] = m_stack[i] > 0 ? Tribool::True : Tribool::False;
         }
-    );
+    }
 }
 
-Literal PartialValuation::decideHeuristic()
+void PartialValuation::rephase(Rephase kind)
 {
-    // Variable State Independent Decaying Sum
-    unsigned n = m_values.size();
-    unsigned candidatePos = NullLiteral;
-    for (unsigned i = 1; i < n; i++)
+    for (unsigned var = 1; var < m_savedPhase.size(); var++)
     {
-        if (m_values[i].value == Tribool::Undefined &&
-                m_values[i].weight >= m_values[candidatePos].weight)
+        switch (kind)
         {
-            candidatePos = i;
+        case Rephase::Original:
+            m_savedPhase[var] = Tribool::True;
+            break;
+        case Rephase::Inverted:
+            m_savedPhase[var] = Tribool::False;
+            break;
+        case Rephase::Best:
+            if (m_bestPhase[var] != Tribool::Undefined)
+            {
+                m_savedPhase[var] = m_bestPhase[var];
+            }
+            break;
         }
     }
-    return candidatePos;
+
+    // the new phases are tried out from scratch
+    std::fill(m_targetPhase.begin(), m_targetPhase.end(), Tribool::Undefined);
+    m_targetSize = 0;
+    m_bestSize = 0;
 }
 
 void PartialValuation::push(Literal l, ClauseIndex reason)
@@ -81,29 +140,18 @@ void PartialValuation::push(Literal l, ClauseIndex reason)
 void PartialValuation::push(Literal l, bool isDecided, ClauseIndex reason)
 {
     unsigned pos = std::abs(l);
-    m_values[pos].value = l > 0 ? Tribool::True : Tribool::False;
-    unsigned level = m_stack.empty() ? 1 : m_stack.back().level;
+    m_litValues[litIndex(l)] = Tribool::True;
+    m_litValues[litIndex(-l)] = Tribool::False;
+    unsigned level = currentLevel();
 
     if (isDecided)
     {
-        decides.push_back(l);
+        m_trailLim.push_back(m_stack.size());
         level++;
     }
-    m_values[pos].level = level;
-    if (isDecided)
-    {
-        m_stack.emplace_back(l, level, true);
-        return;
-    }
-    else if (reason != -1)
-    {
-        m_stack.emplace_back(l, level, reason);
-    }
-    else // doesn't have a reason and it's not decided => it's a negation of previously decided literal
-    {
-        // Uz ucenje klauza i backjumping nikada se ne ulazi ovde
-        m_stack.emplace_back(l, level, false);
-    }
+    m_levels[pos] = level;
+    m_reasons[pos] = isDecided ? NullClause : reason;
+    m_stack.push_back(l);
 }
 
 Literal PartialValuation::backjump()
@@ -115,82 +163,51 @@ Literal PartialValuation::backjump()
 
 
     do {
-        Choice last = m_stack.back();
+        Literal last = m_stack.back();
+        bool isDecided = !m_trailLim.empty() && m_trailLim.back() + 1 == m_stack.size();
         pop();
 
-        if (last.isDecided)
+        if (isDecided)
         {
-            return last.lit;
+            return last;
         }
     } while (m_stack.size());
 
     return NullLiteral;
 }
 
-bool PartialValuation::backjump(Clause& reason)
+void PartialValuation::backjumpToLevel(unsigned level, bool savePhases)
 {
-    if (m_stack.empty())
+    if (currentLevel() <= level)
     {
-        return false;
-    }
-
-    // find 2nd most deepest level of variables in reason clause
-    std::vector<unsigned> levels(reason.size());
-    for (unsigned i = 0; i < reason.size(); i++)
-    {
-        levels[i] = m_values[std::abs(reason[i])].level;
-    }
-
-    unsigned backjumpToLevel;
-
-    if (reason.size() < 2)
-    {
-        if (reason.size() == 0)
-        {
-            throw std::runtime_error("reason clause has 0 elements");
-        }
-        Literal l = reason.back();
-        // if there's only one variable in learned clause, than it's only that decided literals fault
-        backjumpToLevel = m_values[std::abs(l)].level - 1;
-    }
-    else
-    {
-        std::nth_element(levels.begin(), levels.end() - 2, levels.end());
-        backjumpToLevel = levels[levels.size() - 2];
+        return;
     }
 
-    while(m_stack.size() && m_stack.back().level > backjumpToLevel)
+    // everything from the first literal of level+1 on is undone
+    unsigned levelStart = m_trailLim[level];
+    for (unsigned i = m_stack.size(); i > levelStart; i--)
     {
-        pop();
+        ClearVariable(m_stack[i-1], savePhases);
     }
-    return true;
+    m_stack.erase(m_stack.begin() + levelStart, m_stack.end());
+    m_trailLim.resize(level);
 }
 
-bool PartialValuation::isClauseFalse(const Clause &c) const
+bool PartialValuation::isClauseFalse(const ArenaClause &c) const
 {
     /* Za svaki literal klauze proveravamo da li se njegov suprotni nalazi u parc. val. */
-    for (Literal l : c)
-    {
-        Tribool variableInClause = l > 0 ? Tribool::True : Tribool::False;
-        Tribool variableInValuation = m_values[std::abs(l)].value;
-        if (variableInClause == variableInValuation || variableInValuation == Tribool::Undefined)
-        {
-            return false;
-        }
-    }
-    return true;
+    return firstNonFalse(c.begin(), 0, c.size(), m_litValues.data()) == -1;
 }
 
-Literal PartialValuation::isClauseUnit(const Clause &c) const
+Literal PartialValuation::isClauseUnit(const ArenaClause &c) const
 {
     Literal undefinedLit = NullLiteral;
     int cntUndefined = 0;
 
     for (Literal l : c)
     {
-        Tribool valueInClause = l > 0 ? Tribool::True : Tribool::False;
-        Tribool valueInValuation = m_values[std::abs(l)].value;
-        if (valueInClause != valueInValuation)
+        Tribool valueInValuation = value(l);
+        if (valueInValuation != Tribool::True)
         {
             if (valueInValuation == Tribool::Undefined)
             {
@@ -213,30 +230,26 @@ Literal PartialValuation::isClauseUnit(const Clause &c) const
 
 Literal PartialValuation::firstUndefined() const
 {
-    auto it = std::find(m_values.cbegin()+1, m_values.cend(), c_defaultLiteralInfo);
-    return it != m_values.cend() ? it-m_values.cbegin() : NullLiteral;
-}
-
-bool PartialValuation::isLiteralTrue(Literal lit)
-{
-    Tribool litInClause = lit > 0 ? Tribool::True : Tribool::False;
-    Tribool litInValuation = m_values[std::abs(lit)].value;
-    return litInClause == litInValuation;
-}
-
-bool PartialValuation::isLiteralUndefined(Literal lit)
-{
-    return m_values[std::abs(lit)].value == Tribool::Undefined;
+    for (unsigned var = 1; var < m_levels.size(); var++)
+    {
+        if (m_litValues[2 * var] == Tribool::Undefined)
+        {
+            return var;
+        }
+    }
+    return NullLiteral;
 }
 
-int PartialValuation::posOfFirstNonFalseInClause(Clause &currClause, int startInd)
+int PartialValuation::posOfFirstNonFalseInClause(const ArenaClause &currClause, int startInd)
 {
-    for (unsigned j = startInd; j < currClause.size(); j++)
+    unsigned size = currClause.size();
+    if (size - startInd >= c_vectorScanLength)
     {
-        Literal l = currClause[j];
-        Tribool variableInClause = l > 0 ? Tribool::True : Tribool::False;
-        Tribool variableInValuation = values()[std::abs(l)].value;
-        if (variableInClause == variableInValuation || variableInValuation == Tribool::Undefined)
+        return firstNonFalse(currClause.begin(), startInd, size, m_litValues.data());
+    }
+    for (unsigned j = startInd; j < size; j++)
+    {
+        if (!isLiteralFalse(currClause[j]))
         {
             return j;
         }
@@ -246,27 +259,63 @@ int PartialValuation::posOfFirstNonFalseInClause(Clause &currClause, int startIn
 
 void PartialValuation::reset(unsigned nVars)
 {
-    m_values.resize(nVars+1);
-    std::fill(m_values.begin(), m_values.end(), c_defaultLiteralInfo);
+    m_litValues.assign(2 * (nVars+1) + c_scanPadding, Tribool::Undefined);
+    m_levels.assign(nVars+1, 0);
+    m_reasons.assign(nVars+1, NullClause);
+    m_order.reset(nVars);
+    m_eliminated.assign(nVars+1, 0);
+    m_savedPhase.assign(nVars+1, Tribool::True);
+    m_targetPhase.assign(nVars+1, Tribool::Undefined);
+    m_bestPhase.assign(nVars+1, Tribool::Undefined);
+    m_targetSize = 0;
+    m_bestSize = 0;
 
     m_stack.clear();
     m_stack.reserve(nVars * c_stackSizeMultiplier);
+    m_trailLim.clear();
+}
+
+void PartialValuation::grow(unsigned nVars)
+{
+    if (nVars < m_levels.size())
+    {
+        return;
+    }
+    m_litValues.resize(2 * (nVars+1) + c_scanPadding, Tribool::Undefined);
+    m_levels.resize(nVars+1, 0);
+    m_reasons.resize(nVars+1, NullClause);
+    m_order.grow(nVars);
+    m_eliminated.resize(nVars+1, 0);
+    m_savedPhase.resize(nVars+1, Tribool::True);
+    m_targetPhase.resize(nVars+1, Tribool::Undefined);
+    m_bestPhase.resize(nVars+1, Tribool::Undefined);
+}
+
+void PartialValuation::unassignAll()
+{
+    for (unsigned i = m_stack.size(); i > 0; i--)
+    {
+        ClearVariable(m_stack[i-1], false);
+    }
+    m_stack.clear();
+    m_trailLim.clear();
 }
 
 std::ostream &operator<<(std::ostream &out, const PartialValuation &pval)
 { 
     out << "[ ";
-    for (std::size_t i = 1; i < pval.m_values.size(); ++i)
+    for (std::size_t i = 1; i < pval.m_levels.size(); ++i)
     {
-        if (pval.m_values[i].value == Tribool::True)
+        Tribool value = pval.value(i);
+        if (value == Tribool::True)
         {
             out << 'p' << i << ' ';
         }
-        else if (pval.m_values[i].value == Tribool::False)
+        else if (value == Tribool::False)
         {
             out << "~p" << i << ' ';
         }
-        else if (pval.m_values[i].value == Tribool::Undefined)
+        else if (value == Tribool::Undefined)
         {
             out << 'u' << i << ' ';
         }
@@ -2,6 +2,8 @@
 #define PARTIALVALUATION_H
 
 #include "choice.h"
+#include "clause_arena.h"
+#include "variable_heap.h"
 
 #include <vector>
 #include <iostream>
@@ -17,13 +19,25 @@
  */
 using Literal = int;
 using Clause = std::vector<Literal>;
-using CNFFormula = std::vector<Clause>;
 
 /**
  * S obzirom na to da cemo za literale koristiti oznacene celobrojne vrednosti 0 je specijalna vrednost.
  */
 const Literal NullLiteral = 0;
 
+/**
+ * @brief The Rephase enum - how saved phases are reset by PartialValuation::rephase
+ */
+enum class Rephase
+{
+    // every variable back to the initial positive phase
+    Original,
+    // every variable to the negative phase
+    Inverted,
+    // phases of the longest conflict-free assignment seen so far
+    Best
+};
+
 /**
  * Deklaracija klase i operatora za ispis u stream.
  */
@@ -38,12 +52,11 @@ class PartialValuation
 {
 public:
     // used for debugging
-    std::vector<Literal> decides;
     void getValues(Clause * c) const
     {
         for (unsigned i=0; i < c->size(); i++)
         {
-            auto tribool = m_values[abs(c->at(i))].value;
+            auto tribool = value(c->at(i));
             if (tribool == Tribool::True)
             {
                 std::cout << "T";
@@ -66,21 +79,82 @@ public:
 
     unsigned stackSize() const;
     /**
-     * @brief updateWeights - increases the weights of literals in a given clause
-     * @param c - learnt clause
+     * @brief bumpWeight - increases the weight of the literal's variable
+     * @param l - literal involved in a conflict
      */
-    void updateWeights(Clause& c);
+    void bumpWeight(Literal l);
 
     /**
-     * @brief updateWeights - lowers the value of all weights
+     * @brief updateWeights - lowers the value of all weights, called once per conflict
      */
     void updateWeights();
 
     /**
-     * @brief decideHeuristic - heuristic based on VSIDS
+     * @brief decideHeuristic - heuristic based on VSIDS, pops the most active
+     * undefined variable from the heap in O(log n)
      * @return decided literal
      */
     Literal decideHeuristic();
+
+    /**
+     * @brief setUseTargetPhase - when on, decisions follow the target phase of a variable
+     * instead of its saved phase, if it has one
+     */
+    void setUseTargetPhase(bool useTargetPhase)
+    {
+        m_useTargetPhase = useTargetPhase;
+    }
+
+    /**
+     * @brief updateTargetPhases - remembers phases of the conflict-free part of the stack
+     * (all levels below the current one) if it's the longest since the last restart
+     * or the longest since the last rephase. Called on every conflict before backjumping.
+     */
+    void updateTargetPhases();
+
+    /**
+     * @brief resetTargetPhases - starts looking for a new target, called on restart
+     */
+    void resetTargetPhases()
+    {
+        m_targetSize = 0;
+    }
+
+    /**
+     * @brief randomizeOrder - gives variables tiny random activities, which only decide
+     * between variables that weren't in any conflict yet
+     */
+    void randomizeOrder(unsigned seed)
+    {
+        m_order.randomize(seed);
+    }
+
+    /**
+     * @brief eliminate - the variable was removed from the formula, it's never decided
+     */
+    void eliminate(unsigned var)
+    {
+        m_eliminated[var] = 1;
+    }
+
+    bool isEliminated(unsigned var) const
+    {
+        return m_eliminated[var];
+    }
+
+    /**
+     * @brief restore - the variable's clauses were added back to the formula, it's decided again
+     */
+    void restore(unsigned var)
+    {
+        m_eliminated[var] = 0;
+        m_order.insert(var);
+    }
+
+    /**
+     * @brief rephase - overwrites all saved phases
+     */
+    void rephase(Rephase kind);
     /**
     * @brief push - set value of variable in valuation based on literal
     * @param l - literal
@@ -89,18 +163,13 @@ public:
     */
     void push(Literal l, ClauseIndex reason);
 
-    void push(Literal l, bool isDecided, ClauseIndex reason = -1);
+    void push(Literal l, bool isDecided, ClauseIndex reason = NullClause);
 
     /**
      * @brief pop the top of the stack of valuation
      */
     void pop();
 
-    /**
-     * @brief back - gets the choice from top of the stack
-     * @return the choice on top of the stack
-     */
-    Choice& back() const;
     /**
     * @brief backtrack - skida literale sa steka sve do prvog decide literala na koji naidje
     * @return poslednji decide literal ili NullLiteral ukoliko takvog nema
@@ -108,11 +177,38 @@ public:
     Literal backjump();
 
     /**
-     * @brief backtrack to when the 2nd most level variable involved in the conflict was assigned
-     * @param cut - clause of variables involved in the conflict
-     * @return if backtracking succeeded or not (case of failure means UNSAT)
+     * @brief backjumpToLevel - truncates the stack to the start of level+1 and unassigns
+     * the removed literals, without popping them one by one
+     * @param level - decision level to which to backjump, 0 is the root level
+     * @param savePhases - false when the undone values were only tried out (e.g. by probing)
+     * and shouldn't become saved phases
+     */
+    void backjumpToLevel(unsigned level, bool savePhases = true);
+
+    /**
+     * @brief newLevel - opens a decision level without a decided literal, for an assumption
+     * which is already true, so that levels keep matching assumptions
+     */
+    void newLevel()
+    {
+        m_trailLim.push_back(m_stack.size());
+    }
+
+    /**
+     * @brief rootSize - number of literals assigned at level 0, which stay assigned for good
      */
-    bool backjump(Clause& learned);
+    unsigned rootSize() const
+    {
+        return m_trailLim.empty() ? m_stack.size() : m_trailLim[0];
+    }
+
+    /**
+     * @brief currentLevel - decision level of the top of the stack, 0 before any decision
+     */
+    unsigned currentLevel() const
+    {
+        return m_trailLim.size();
+    }
 
     /**
     * @brief isClauseFalse - proverava da li je klauza netacna u tekucoj parcijalnoj valuaciji.
@@ -122,7 +218,7 @@ public:
     * @param c - klauza koja se proverava
     * @return true ako je klauza netacna, false inace
     */
-    bool isClauseFalse(const Clause &c) const;
+    bool isClauseFalse(const ArenaClause &c) const;
 
     /**
     * @brief isClauseUnit - proverava da li je klauza jedinicna zbog propagacije jedinicnog literala.
@@ -132,7 +228,7 @@ public:
     * @param c - klauza koja se proverava
     * @return literal koji je jedini nedefinisan u tekucoj klauzi
     */
-    Literal isClauseUnit(const Clause &c) const;
+    Literal isClauseUnit(const ArenaClause &c) const;
 
     /**
     * @brief firstUndefined - trazi prvi nedefinisani literal u valuaciji
@@ -144,11 +240,76 @@ public:
     */
     Literal firstUndefined() const;
 
-    bool isLiteralTrue(Literal lit);
+    /**
+     * @brief value - True if lit is true, False if it's false (its negation is true), Undefined otherwise
+     */
+    Tribool value(Literal lit) const
+    {
+        return m_litValues[litIndex(lit)];
+    }
+
+    bool isLiteralTrue(Literal lit) const
+    {
+        return m_litValues[litIndex(lit)] == Tribool::True;
+    }
+
+    bool isLiteralFalse(Literal lit) const
+    {
+        return m_litValues[litIndex(lit)] == Tribool::False;
+    }
+
+    bool isLiteralUndefined(Literal lit) const
+    {
+        return m_litValues[litIndex(lit)] == Tribool::Undefined;
+    }
 
-    bool isLiteralUndefined(Literal lit);
+    /**
+     * @brief level - decision level at which var was assigned, 0 if it's undefined
+     */
+    unsigned level(unsigned var) const
+    {
+        return m_levels[var];
+    }
 
-    int posOfFirstNonFalseInClause(Clause &currClause, int startInd);
+    /**
+     * @brief reason - clause which implied the value of var, NullClause for decided and undefined variables
+     */
+    ClauseIndex reason(unsigned var) const
+    {
+        return m_reasons[var];
+    }
+
+    /**
+     * @brief setReason - the reason clause was moved to a new index (e.g. by garbage collection)
+     */
+    void setReason(unsigned var, ClauseIndex reason)
+    {
+        m_reasons[var] = reason;
+    }
+
+    /**
+     * @brief setModelValue - makes lit true without putting it on the stack, for completing a model
+     * with values of eliminated variables
+     */
+    void setModelValue(Literal lit)
+    {
+        m_litValues[litIndex(lit)] = Tribool::True;
+        m_litValues[litIndex(-lit)] = Tribool::False;
+    }
+
+    /**
+     * @brief varCount - number of variables, which are numbered from 1
+     */
+    unsigned varCount() const
+    {
+        return m_levels.size() - 1;
+    }
+
+    /**
+     * @brief posOfFirstNonFalseInClause - position of the first literal from startInd on which isn't false
+     * @return the position, or -1 if the rest of the clause is false
+     */
+    int posOfFirstNonFalseInClause(const ArenaClause &currClause, int startInd);
     /**
     * @brief reset - postavlja parcijalnu valuaciju u pocetnu poziciju
     *
@@ -157,14 +318,22 @@ public:
     */
     void reset(unsigned nVars);
 
-    std::vector<Choice>& stack()
-    {
-        return m_stack;
-    }
+    /**
+     * @brief grow - adds unassigned variables up to nVars, keeping everything about the existing ones
+     */
+    void grow(unsigned nVars);
+
+    /**
+     * @brief unassignAll - empties the stack, keeping activities and phases
+     */
+    void unassignAll();
 
-    std::vector<LiteralInfo>& values()
+    /**
+     * @brief stack - the assigned literals in order, levels and reasons are in level and reason
+     */
+    const std::vector<Literal>& stack() const
     {
-        return m_values;
+        return m_stack;
     }
 
     friend std::ostream& operator<<(std::ostream &out, const PartialValuation &pval);
@@ -174,12 +343,7 @@ private:
      * @brief ClearVariable - clears info of variable which the given literal is referring to
      * @param l - literal whose variable shall be cleared
      */
-    void ClearVariable(Literal l);
-
-    /**
-     * @brief divideWeightsBy how much to divide weigts when calling their update
-     */
-    const float divideWeightsBy = 2.0f;
+    void ClearVariable(Literal l, bool savePhase = true);
 
     /**
      * @brief c_stackSizeMultiplier - for each decided literal there will be
@@ -188,14 +352,60 @@ private:
     const unsigned c_stackSizeMultiplier = 2;
 
     /**
-    * @brief m_values - vector of variable values and their levels
+     * @brief c_vectorScanLength - shorter parts of clauses are scanned inline, for them a call
+     * to the vectorized firstNonFalse costs more than it saves
+     */
+    static const unsigned c_vectorScanLength = 16;
+
+    /**
+    * @brief m_litValues - value of every literal, indexed by litIndex. Both literals of a variable
+    * are set on every assignment, so a check of any literal is a single byte load without
+    * a branch on its sign, and a cache line holds the values of 32 variables.
+    * It's followed by c_scanPadding unused values for the vectorized firstNonFalse.
+    */
+    std::vector<Tribool> m_litValues;
+
+    /**
+    * @brief m_levels, m_reasons - the rest of the assignment, indexed by variable and only
+    * read by conflict analysis, so it's kept out of the way of the values
+    */
+    std::vector<unsigned> m_levels;
+    std::vector<ClauseIndex> m_reasons;
+
+    /**
+    * @brief m_order - variables ordered by their activity (weight)
+    */
+    VariableHeap m_order;
+
+    /**
+    * @brief m_eliminated - variables removed from the formula by preprocessing
+    */
+    std::vector<char> m_eliminated;
+
+    /**
+    * @brief m_savedPhase - last value of each variable, recorded when it's unassigned
+    */
+    std::vector<Tribool> m_savedPhase;
+
+    /**
+    * @brief m_targetPhase, m_bestPhase - values from the longest conflict-free assignments
+    * since the last restart and since the last rephase, Undefined if there are none
+    */
+    std::vector<Tribool> m_targetPhase;
+    std::vector<Tribool> m_bestPhase;
+    unsigned m_targetSize;
+    unsigned m_bestSize;
+    bool m_useTargetPhase;
+
+    /**
+    * @brief m_stack - holds the history of selected literals, the decided ones are found by m_trailLim
     */
-    std::vector<LiteralInfo> m_values;
+    std::vector<Literal> m_stack;
 
     /**
-    * @brief m_stack - holds the history of selected literals
+    * @brief m_trailLim - index in m_stack of the decided literal of each level, starting with level 1
     */
-    std::vector<Choice> m_stack;
+    std::vector<unsigned> m_trailLim;
 
 };
 
@@ -0,0 +1,83 @@
+#!/bin/bash
+# Builds the plain (-O2) and the LTO + profile-guided CDCL, trains the profile on the given
+# instances and reports the speedup of the optimized binary on them.
+#
+# usage: ./pgo.sh [instance.cnf ...]
+#   instances default to the bundled sudoku.cnf, sat.cnf and unsat.cnf
+#   QMAKE  - qmake to use (qmake)
+#   BUILD  - build directory (../build-pgo)
+#   RUNS   - timed runs of each binary on each instance (10)
+#   TRAIN  - training runs on each instance (3)
+
+set -e
+
+SOURCE=$(cd "$(dirname "$0")" && pwd)
+QMAKE=${QMAKE:-qmake}
+BUILD=${BUILD:-$SOURCE/../build-pgo}
+RUNS=${RUNS:-10}
+TRAIN=${TRAIN:-3}
+JOBS=$(nproc 2>/dev/null || echo 2)
+
+if [ $# -gt 0 ]; then
+    INSTANCES=("$@")
+else
+    INSTANCES=("$SOURCE/sudoku.cnf" "$SOURCE/sat.cnf" "$SOURCE/unsat.cnf")
+fi
+
+mkdir -p "$BUILD/plain" "$BUILD/pgo"
+BUILD=$(cd "$BUILD" && pwd)
+PROFILE="$BUILD/pgo/profile"
+
+build()
+{
+    local dir=$1
+    shift
+    (cd "$dir" && "$QMAKE" "$SOURCE/CDCL.pro" CONFIG+=release "$@" > /dev/null \
+        && make clean > /dev/null && make -j"$JOBS" > /dev/null)
+}
+
+echo "building the plain binary"
+build "$BUILD/plain" CONFIG+=no_lto
+
+echo "building the instrumented binary"
+rm -rf "$PROFILE"
+build "$BUILD/pgo" CONFIG+=pgo_generate PGO_DIR="$PROFILE"
+
+echo "training on ${#INSTANCES[@]} instances"
+for ((i = 0; i < TRAIN; i++)); do
+    for cnf in "${INSTANCES[@]}"; do
+        "$BUILD/pgo/CDCL_pgo_gen" "$cnf" > /dev/null
+    done
+done
+
+# clang writes raw profiles, which have to be merged before they can be used
+if ls "$PROFILE"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output="$PROFILE/default.profdata" "$PROFILE"/*.profraw
+fi
+
+echo "building the optimized binary"
+build "$BUILD/pgo" CONFIG+=pgo_use PGO_DIR="$PROFILE"
+
+# total wall time in seconds of RUNS runs of binary $1 on instance $2
+measure()
+{
+    local TIMEFORMAT=%R
+    { time (for ((r = 0; r < RUNS; r++)); do "$1" "$2" > /dev/null; done) ; } 2>&1
+}
+
+echo
+printf "%-24s %12s %12s %8s\n" instance "plain (ms)" "pgo (ms)" speedup
+plainTotal=0
+pgoTotal=0
+for cnf in "${INSTANCES[@]}"; do
+    plain=$(measure "$BUILD/plain/CDCL" "$cnf")
+    pgo=$(measure "$BUILD/pgo/CDCL_pgo" "$cnf")
+    plainTotal=$(awk "BEGIN { print $plainTotal + $plain }")
+    pgoTotal=$(awk "BEGIN { print $pgoTotal + $pgo }")
+    awk -v name="$(basename "$cnf")" -v a="$plain" -v b="$pgo" -v n="$RUNS" \
+        'BEGIN { printf "%-24s %12.1f %12.1f %7.2fx\n", name, 1000 * a / n, 1000 * b / n, (b > 0 ? a / b : 0) }'
+done
+awk -v a="$plainTotal" -v b="$pgoTotal" -v n="$RUNS" \
+    'BEGIN { printf "%-24s %12.1f %12.1f %7.2fx\n", "total", 1000 * a / n, 1000 * b / n, (b > 0 ? a / b : 0) }'
+echo
+echo "optimized binary: $BUILD/pgo/CDCL_pgo"
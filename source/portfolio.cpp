@@ -0,0 +1,136 @@
+#include "portfolio.h"
+
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief The Portfolio::Sharing class - connects one worker with the rings of all workers,
+ * it writes to its own ring and keeps a read position in each of the others
+ */
+class Portfolio::Sharing : public ClauseSharing
+{
+public:
+    Sharing(std::vector<std::unique_ptr<ExportRing>>& rings, unsigned index)
+        : m_rings(rings), m_index(index), m_cursors(rings.size(), 0)
+    {
+    }
+
+    void exportClause(const Clause& clause, unsigned lbd) override
+    {
+        m_rings[m_index]->push(clause, lbd);
+    }
+
+    void importClauses(std::vector<Literal>& out) override
+    {
+        for (unsigned i = 0; i < m_rings.size(); i++)
+        {
+            if (i != m_index)
+            {
+                m_rings[i]->read(m_cursors[i], out);
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<ExportRing>>& m_rings;
+    unsigned m_index;
+    std::vector<std::uint64_t> m_cursors;
+};
+
+Portfolio::Portfolio(const DimacsFormula& formula, unsigned threads)
+    : m_clauses(formula), m_threads(threads), m_stop(false)
+{
+    if (threads == 0)
+    {
+        throw std::runtime_error{"Portfolio needs at least one thread"};
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        m_rings.emplace_back(new ExportRing());
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        m_sharing.emplace_back(new Sharing(m_rings, i));
+    }
+    m_info.resize(threads);
+}
+
+Portfolio::~Portfolio() = default;
+
+void Portfolio::configure(Solver& solver, unsigned index)
+{
+    static const RestartStrategy strategies[] = {RestartStrategy::Luby, RestartStrategy::Glucose,
+                                                 RestartStrategy::Geometric};
+    solver.setRestartStrategy(strategies[index % 3]);
+    // worker 0 keeps the default configuration, so a portfolio is never worse than one solver
+    if (index > 0)
+    {
+        solver.setSeed(index);
+        solver.setInitialPhase(index % 2 == 0);
+        solver.UseTargetPhase = index % 4 != 3;
+        // the elimination stack is needed for the model, one preprocessed worker is enough
+        solver.UsePreprocessing = false;
+    }
+}
+
+void Portfolio::runWorker(unsigned index)
+{
+    Solver solver{m_clauses};
+    solver.UseLearning = true;
+    configure(solver, index);
+    solver.setClauseSharing(m_threads > 1 ? m_sharing[index].get() : nullptr);
+    solver.setTerminateFlag(&m_stop);
+
+    OptionalPartialValuation solution = solver.solve2();
+    m_info[index] = solver.getInfo();
+    if (solver.status() == SolveResult::Unknown)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    if (!m_stop.exchange(true))
+    {
+        m_result = solver.status();
+        if (solution)
+        {
+            m_solution.emplace(std::move(*solution));
+        }
+        m_winner = index;
+    }
+}
+
+SolveResult Portfolio::solve()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < m_threads; i++)
+    {
+        workers.emplace_back(&Portfolio::runWorker, this, i);
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return m_result;
+}
+
+std::string Portfolio::getInfo() const
+{
+    std::ostringstream info;
+    info << "Portfolio: " << m_threads << " workers, winner " << m_winner
+         << " after " << m_seconds << " s\n";
+    for (unsigned i = 0; i < m_info.size(); i++)
+    {
+        if (!m_info[i].empty())
+        {
+            info << "Worker " << i << ":\n" << m_info[i] << "\n";
+        }
+    }
+    return info.str();
+}
@@ -0,0 +1,89 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "solver.h"
+#include "dimacs_parser.h"
+#include "clause_sharing.h"
+#include "shared_clauses.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief The Portfolio class - runs several differently configured solvers on the same formula
+ * in parallel threads, the first one to find the answer stops all the others.
+ *
+ * @details Workers differ in restart policy, random seed, initial phase and phase selection,
+ * so they explore the search space in different orders. Every worker publishes its short and
+ * low-LBD learned clauses to its own ExportRing, and imports clauses of all the other workers
+ * from their rings on each restart.
+ *
+ * The original clauses are stored once in SharedClauses, which all workers only read. A worker
+ * keeps its own watches and watched literals for them, and its learned clauses in its own arena.
+ * Worker 0 preprocesses the formula, so it ends up with its own copy of the simplified clauses.
+ */
+class Portfolio
+{
+public:
+    /**
+     * @param formula - isn't needed after the constructor
+     * @param threads - number of workers, at least one
+     */
+    Portfolio(const DimacsFormula& formula, unsigned threads);
+
+    ~Portfolio();
+
+    /**
+     * @brief solve - runs all workers until one of them answers
+     */
+    SolveResult solve();
+
+    /**
+     * @brief solution - model found by the winner, if the formula is SAT
+     */
+    const OptionalPartialValuation& solution() const
+    {
+        return m_solution;
+    }
+
+    /**
+     * @brief winner - index of the worker which answered first
+     */
+    unsigned winner() const
+    {
+        return m_winner;
+    }
+
+    std::string getInfo() const;
+
+private:
+    class Sharing;
+
+    /**
+     * @brief configure - diversifies the worker with the given index
+     */
+    static void configure(Solver& solver, unsigned index);
+
+    void runWorker(unsigned index);
+
+    SharedClauses m_clauses;
+    unsigned m_threads;
+
+    std::vector<std::unique_ptr<ExportRing>> m_rings;
+    std::vector<std::unique_ptr<Sharing>> m_sharing;
+    // statistics of every worker, taken when it stops, so that its solver can be freed
+    std::vector<std::string> m_info;
+
+    std::atomic<bool> m_stop;
+
+    std::mutex m_resultMutex;
+    SolveResult m_result = SolveResult::Unknown;
+    OptionalPartialValuation m_solution;
+    unsigned m_winner = 0;
+    double m_seconds = 0;
+};
+
+#endif // PORTFOLIO_H
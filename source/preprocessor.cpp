@@ -0,0 +1,543 @@
+#include "preprocessor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "partial_valuation.h"
+
+Preprocessor::Preprocessor(unsigned nVars, ProofWriter* proof)
+    : m_occurs(2 * (nVars + 1)),
+    m_values(nVars + 1, Tribool::Undefined),
+    m_eliminated(nVars + 1, 0),
+    m_frozen(nVars + 1, 0),
+    m_touched(nVars + 1, 0),
+    m_marks(2 * (nVars + 1), 0),
+    m_proof(proof)
+{
+}
+
+std::uint64_t Preprocessor::signature(const Clause& clause)
+{
+    // one bit per variable, so a clause which differs in a sign is still a candidate for strengthening
+    std::uint64_t sig = 0;
+    for (Literal l : clause)
+    {
+        sig |= std::uint64_t(1) << (std::abs(l) & 63);
+    }
+    return sig;
+}
+
+void Preprocessor::addClause(const Clause& clause)
+{
+    if (clause.empty())
+    {
+        m_ok = false;
+    }
+    else if (clause.size() == 1)
+    {
+        assign(clause[0]);
+    }
+    else
+    {
+        pushClause(clause);
+    }
+}
+
+unsigned Preprocessor::pushClause(const Clause& clause)
+{
+    unsigned clauseIdx = m_clauses.size();
+    m_clauses.push_back(clause);
+    m_signatures.push_back(signature(clause));
+    m_removed.push_back(0);
+    m_queued.push_back(0);
+    for (Literal l : clause)
+    {
+        m_occurs[litIndex(l)].push_back(clauseIdx);
+    }
+    touch(clause);
+    return clauseIdx;
+}
+
+void Preprocessor::removeClause(unsigned clauseIdx)
+{
+    // a clause strengthened to a unit lives on as the assigned unit
+    if (m_proof && m_clauses[clauseIdx].size() > 1)
+    {
+        m_proof->remove(m_clauses[clauseIdx]);
+    }
+    // occurrence lists still have it, they are cleaned when they're used
+    m_removed[clauseIdx] = 1;
+    touch(m_clauses[clauseIdx]);
+    Clause().swap(m_clauses[clauseIdx]);
+}
+
+void Preprocessor::strengthen(unsigned clauseIdx, Literal lit)
+{
+    Clause& clause = m_clauses[clauseIdx];
+    if (m_proof)
+    {
+        m_proofClause = clause;
+    }
+    clause.erase(std::find(clause.begin(), clause.end(), lit));
+    if (m_proof)
+    {
+        m_proof->add(clause);
+        m_proof->remove(m_proofClause);
+    }
+    m_stats.strengthenedLiterals++;
+    touch(clause);
+
+    std::vector<unsigned>& occurs = m_occurs[litIndex(lit)];
+    auto it = std::find(occurs.begin(), occurs.end(), clauseIdx);
+    if (it != occurs.end())
+    {
+        *it = occurs.back();
+        occurs.pop_back();
+    }
+
+    if (clause.size() == 1)
+    {
+        assign(clause[0]);
+        removeClause(clauseIdx);
+        return;
+    }
+    m_signatures[clauseIdx] = signature(clause);
+    // a shorter clause may subsume more clauses now
+    if (!m_queued[clauseIdx])
+    {
+        m_queued[clauseIdx] = 1;
+        m_queue.push_back(clauseIdx);
+    }
+}
+
+void Preprocessor::touch(const Clause& clause)
+{
+    for (Literal l : clause)
+    {
+        unsigned var = std::abs(l);
+        if (!m_touched[var])
+        {
+            m_touched[var] = 1;
+            m_touchedVars.push_back(var);
+        }
+    }
+}
+
+void Preprocessor::assign(Literal lit)
+{
+    unsigned var = std::abs(lit);
+    Tribool value = lit > 0 ? Tribool::True : Tribool::False;
+    if (m_values[var] == Tribool::Undefined)
+    {
+        m_values[var] = value;
+        m_units.push_back(lit);
+    }
+    else if (m_values[var] != value)
+    {
+        m_ok = false;
+    }
+}
+
+void Preprocessor::propagateUnits()
+{
+    while (m_ok && m_propagated < m_units.size())
+    {
+        Literal lit = m_units[m_propagated++];
+        for (unsigned clauseIdx : m_occurs[litIndex(lit)])
+        {
+            if (!m_removed[clauseIdx])
+            {
+                removeClause(clauseIdx);
+                m_stats.satisfiedClauses++;
+            }
+        }
+        std::vector<unsigned>().swap(m_occurs[litIndex(lit)]);
+
+        // strengthen removes clauses from the list, so it's taken out first
+        std::vector<unsigned> falseIn;
+        falseIn.swap(m_occurs[litIndex(-lit)]);
+        for (unsigned clauseIdx : falseIn)
+        {
+            if (!m_removed[clauseIdx])
+            {
+                strengthen(clauseIdx, -lit);
+            }
+        }
+    }
+}
+
+void Preprocessor::backwardSubsume(unsigned clauseIdx)
+{
+    if (m_removed[clauseIdx])
+    {
+        return;
+    }
+    const Clause& clause = m_clauses[clauseIdx];
+
+    // every clause which clause subsumes or strengthens contains its literal or its negation,
+    // so it's enough to check clauses of the rarest one
+    Literal best = clause[0];
+    std::size_t bestCount = SIZE_MAX;
+    for (Literal l : clause)
+    {
+        std::size_t count = m_occurs[litIndex(l)].size() + m_occurs[litIndex(-l)].size();
+        if (count < bestCount)
+        {
+            best = l;
+            bestCount = count;
+        }
+    }
+
+    mark(clause);
+
+    // strengthening changes the occurrence lists, so candidates are copied first
+    m_candidates.assign(m_occurs[litIndex(best)].begin(), m_occurs[litIndex(best)].end());
+    m_candidates.insert(m_candidates.end(), m_occurs[litIndex(-best)].begin(), m_occurs[litIndex(-best)].end());
+
+    const std::uint64_t sig = m_signatures[clauseIdx];
+    for (unsigned other : m_candidates)
+    {
+        if (!m_ok)
+        {
+            return;
+        }
+        if (other == clauseIdx || m_removed[other] || m_clauses[other].size() < clause.size() ||
+                (sig & ~m_signatures[other]) != 0)
+        {
+            continue;
+        }
+
+        // clause subsumes other if all of its literals are in it, and strengthens it
+        // if all but one are, and that one is there negated
+        std::size_t found = 0;
+        Literal flipped = NullLiteral;
+        bool fail = false;
+        for (Literal l : m_clauses[other])
+        {
+            if (m_marks[litIndex(l)] == m_stamp)
+            {
+                found++;
+            }
+            else if (m_marks[litIndex(-l)] == m_stamp)
+            {
+                if (flipped != NullLiteral)
+                {
+                    fail = true;
+                    break;
+                }
+                flipped = l;
+                found++;
+            }
+        }
+        if (fail || found < clause.size())
+        {
+            continue;
+        }
+
+        if (flipped == NullLiteral)
+        {
+            removeClause(other);
+            m_stats.subsumedClauses++;
+        }
+        else
+        {
+            strengthen(other, flipped);
+        }
+    }
+}
+
+void Preprocessor::subsumeQueued()
+{
+    propagateUnits();
+    while (m_ok && !m_queue.empty() && !outOfTime())
+    {
+        unsigned clauseIdx = m_queue.back();
+        m_queue.pop_back();
+        m_queued[clauseIdx] = 0;
+        backwardSubsume(clauseIdx);
+        propagateUnits();
+    }
+}
+
+std::vector<unsigned>& Preprocessor::cleanOccurs(Literal lit)
+{
+    std::vector<unsigned>& occurs = m_occurs[litIndex(lit)];
+    occurs.erase(std::remove_if(occurs.begin(), occurs.end(),
+                                [this](unsigned clauseIdx) { return m_removed[clauseIdx]; }),
+                 occurs.end());
+    return occurs;
+}
+
+void Preprocessor::mark(const Clause& clause)
+{
+    if (++m_stamp == 0)
+    {
+        std::fill(m_marks.begin(), m_marks.end(), 0);
+        m_stamp = 1;
+    }
+    for (Literal l : clause)
+    {
+        m_marks[litIndex(l)] = m_stamp;
+    }
+}
+
+bool Preprocessor::resolve(const Clause& positive, const Clause& negative, unsigned var)
+{
+    m_resolvent.clear();
+    for (Literal l : positive)
+    {
+        if (static_cast<unsigned>(std::abs(l)) != var)
+        {
+            m_resolvent.push_back(l);
+        }
+    }
+    for (Literal l : negative)
+    {
+        if (static_cast<unsigned>(std::abs(l)) == var)
+        {
+            continue;
+        }
+        if (m_marks[litIndex(-l)] == m_stamp)
+        {
+            return false;
+        }
+        if (m_marks[litIndex(l)] != m_stamp)
+        {
+            m_resolvent.push_back(l);
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::eliminate(unsigned var)
+{
+    if (m_values[var] != Tribool::Undefined || m_eliminated[var] || m_frozen[var])
+    {
+        return false;
+    }
+    std::vector<unsigned>& positive = cleanOccurs(var);
+    std::vector<unsigned>& negative = cleanOccurs(-static_cast<Literal>(var));
+    if ((positive.empty() && negative.empty()) || positive.size() * negative.size() > c_maxResolutions)
+    {
+        return false;
+    }
+
+    // all resolvents are made before anything is changed, the elimination may still be abandoned
+    const std::size_t limit = positive.size() + negative.size() + c_clauseGrowth;
+    std::size_t count = 0;
+    m_resolvents.clear();
+    for (unsigned pos : positive)
+    {
+        // var itself is marked too, but only -var could be found in the negative clauses
+        mark(m_clauses[pos]);
+        for (unsigned neg : negative)
+        {
+            if (!resolve(m_clauses[pos], m_clauses[neg], var))
+            {
+                continue;
+            }
+            if (++count > limit || m_resolvent.size() > c_maxResolventSize || outOfTime())
+            {
+                return false;
+            }
+            m_resolvents.insert(m_resolvents.end(), m_resolvent.begin(), m_resolvent.end());
+            m_resolvents.push_back(NullLiteral);
+        }
+    }
+
+    m_eliminated[var] = 1;
+    m_stats.eliminatedVars++;
+
+    // clauses of the side with fewer of them would be enough to extend the model, but the
+    // solver needs all of them to bring the variable back when it's used in a new clause;
+    // the variable gets the value of the other side by default, which is read first
+    bool positiveSmaller = positive.size() <= negative.size();
+    Literal pivot = positiveSmaller ? static_cast<Literal>(var) : -static_cast<Literal>(var);
+    for (unsigned clauseIdx : positiveSmaller ? positive : negative)
+    {
+        pushEliminated(m_clauses[clauseIdx], pivot);
+    }
+    for (unsigned clauseIdx : positiveSmaller ? negative : positive)
+    {
+        pushEliminated(m_clauses[clauseIdx], -pivot);
+    }
+    pushEliminated(Clause{-pivot}, -pivot);
+
+    if (m_proof)
+    {
+        // resolvents follow from the clauses of var, which are deleted next
+        Clause resolvent;
+        for (Literal l : m_resolvents)
+        {
+            if (l != NullLiteral)
+            {
+                resolvent.push_back(l);
+                continue;
+            }
+            m_proof->add(resolvent);
+            resolvent.clear();
+        }
+    }
+
+    for (std::vector<unsigned>* side : {&positive, &negative})
+    {
+        for (unsigned clauseIdx : *side)
+        {
+            removeClause(clauseIdx);
+            m_stats.eliminatedClauses++;
+        }
+        std::vector<unsigned>().swap(*side);
+    }
+
+    Clause resolvent;
+    for (Literal l : m_resolvents)
+    {
+        if (l != NullLiteral)
+        {
+            resolvent.push_back(l);
+            continue;
+        }
+        m_stats.resolvents++;
+        if (resolvent.size() == 1)
+        {
+            assign(resolvent[0]);
+        }
+        else
+        {
+            unsigned clauseIdx = pushClause(resolvent);
+            m_queued[clauseIdx] = 1;
+            m_queue.push_back(clauseIdx);
+        }
+        resolvent.clear();
+    }
+    return true;
+}
+
+void Preprocessor::pushEliminated(const Clause& clause, Literal pivot)
+{
+    m_eliminationStack.push_back(pivot);
+    for (Literal l : clause)
+    {
+        if (l != pivot)
+        {
+            m_eliminationStack.push_back(l);
+        }
+    }
+    m_eliminationStack.push_back(clause.size());
+}
+
+bool Preprocessor::outOfTime()
+{
+    // looking at the clock is much more expensive than a step, so it's done rarely
+    if (!m_stats.timedOut && ++m_steps % 1024 == 0)
+    {
+        m_stats.timedOut = std::chrono::steady_clock::now() > m_deadline;
+    }
+    return m_stats.timedOut;
+}
+
+bool Preprocessor::run(double timeLimit)
+{
+    auto start = std::chrono::steady_clock::now();
+    m_deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(timeLimit));
+
+    // shorter clauses subsume more, so they go first
+    propagateUnits();
+    for (unsigned clauseIdx = 0; clauseIdx < m_clauses.size(); clauseIdx++)
+    {
+        if (!m_removed[clauseIdx])
+        {
+            m_queued[clauseIdx] = 1;
+            m_queue.push_back(clauseIdx);
+        }
+    }
+    std::sort(m_queue.begin(), m_queue.end(), [this](unsigned a, unsigned b) {
+        return m_clauses[a].size() > m_clauses[b].size();
+    });
+    subsumeQueued();
+
+    // variables which are the cheapest to eliminate go first; after the first round only
+    // variables whose clauses changed are tried again, until none of them can be eliminated
+    std::vector<unsigned> candidates;
+    for (unsigned var = 1; var < m_values.size(); var++)
+    {
+        candidates.push_back(var);
+    }
+    std::vector<std::pair<std::size_t, unsigned>> order;
+    while (m_ok && !candidates.empty() && !outOfTime())
+    {
+        order.clear();
+        for (unsigned var : candidates)
+        {
+            m_touched[var] = 0;
+            if (m_values[var] == Tribool::Undefined && !m_eliminated[var])
+            {
+                Literal lit = var;
+                order.emplace_back(m_occurs[litIndex(lit)].size() * m_occurs[litIndex(-lit)].size(), var);
+            }
+        }
+        std::sort(order.begin(), order.end());
+        m_touchedVars.clear();
+
+        for (const auto& candidate : order)
+        {
+            if (!m_ok || outOfTime())
+            {
+                break;
+            }
+            if (eliminate(candidate.second))
+            {
+                subsumeQueued();
+            }
+        }
+        candidates.swap(m_touchedVars);
+    }
+
+    m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return m_ok;
+}
+
+std::vector<Clause> Preprocessor::takeClauses()
+{
+    std::vector<Clause> clauses;
+    clauses.reserve(m_clauses.size() + m_units.size());
+    for (Literal unit : m_units)
+    {
+        clauses.push_back(Clause{unit});
+    }
+    for (unsigned clauseIdx = 0; clauseIdx < m_clauses.size(); clauseIdx++)
+    {
+        if (!m_removed[clauseIdx])
+        {
+            clauses.push_back(std::move(m_clauses[clauseIdx]));
+        }
+    }
+    return clauses;
+}
+
+void Preprocessor::extendModel(const std::vector<Literal>& eliminationStack, PartialValuation& model)
+{
+    // the last eliminated variable is assigned first, its clauses don't contain any
+    // variable eliminated before it
+    std::size_t i = eliminationStack.size();
+    while (i > 0)
+    {
+        std::size_t size = eliminationStack[--i];
+        i -= size;
+
+        bool satisfied = false;
+        for (std::size_t j = i; j < i + size; j++)
+        {
+            if (model.isLiteralTrue(eliminationStack[j]))
+            {
+                satisfied = true;
+                break;
+            }
+        }
+        if (!satisfied)
+        {
+            model.setModelValue(eliminationStack[i]);
+        }
+    }
+}
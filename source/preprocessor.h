@@ -0,0 +1,224 @@
+#ifndef PREPROCESSOR_H
+#define PREPROCESSOR_H
+
+#include "choice.h"
+#include "proof_writer.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+class PartialValuation;
+
+/**
+ * @brief The PreprocessStats struct - what the preprocessor removed from the formula
+ */
+struct PreprocessStats
+{
+    unsigned long long eliminatedVars = 0;
+    // clauses removed together with eliminated variables
+    unsigned long long eliminatedClauses = 0;
+    unsigned long long resolvents = 0;
+    unsigned long long subsumedClauses = 0;
+    // literals removed by self-subsuming resolution
+    unsigned long long strengthenedLiterals = 0;
+    // clauses satisfied by units found during preprocessing
+    unsigned long long satisfiedClauses = 0;
+    double seconds = 0;
+    bool timedOut = false;
+};
+
+/**
+ * @brief The Preprocessor class - simplifies the formula before the search, in the way of SatELite.
+ *
+ * @details Clauses are kept with occurrence lists of their literals. Backward subsumption
+ * removes clauses which contain another clause, and self-subsuming resolution removes a
+ * literal l from a clause D when there is a clause C with ~l such that C\{~l} is a subset of D.
+ * Bounded variable elimination replaces all clauses of a variable with their non-tautological
+ * resolvents, when there are no more of them than the removed clauses.
+ *
+ * Clauses of eliminated variables are kept on an elimination stack, which extendModel uses to
+ * give values to the eliminated variables once the rest of the formula is satisfied.
+ */
+class Preprocessor
+{
+public:
+    /**
+     * @param proof - if not nullptr, gets every clause the preprocessor derives or removes
+     */
+    Preprocessor(unsigned nVars, ProofWriter* proof = nullptr);
+
+    /**
+     * @brief addClause - adds an input clause, which mustn't have duplicate literals or be a tautology
+     */
+    void addClause(const Clause& clause);
+
+    /**
+     * @brief run - simplifies the formula until there is nothing left to do or the time is up
+     * @param timeLimit - in seconds
+     * @return false if the formula is found to be UNSAT
+     */
+    bool run(double timeLimit);
+
+    /**
+     * @brief takeClauses - the simplified formula, values found for variables are unit clauses
+     */
+    std::vector<Clause> takeClauses();
+
+    /**
+     * @brief takeEliminationStack - clauses removed by variable elimination, see extendModel
+     */
+    std::vector<Literal> takeEliminationStack()
+    {
+        return std::move(m_eliminationStack);
+    }
+
+    bool isEliminated(unsigned var) const
+    {
+        return m_eliminated[var];
+    }
+
+    /**
+     * @brief freeze - var will be used after preprocessing (e.g. in assumptions), so it's never eliminated
+     */
+    void freeze(unsigned var)
+    {
+        m_frozen[var] = 1;
+    }
+
+    const PreprocessStats& stats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * @brief extendModel - assigns eliminated variables, so that the model satisfies the clauses
+     * which were removed together with them
+     * @param eliminationStack - clauses one after another, each one with the eliminated literal
+     * first and followed by its size
+     * @param model - model of the simplified formula
+     */
+    static void extendModel(const std::vector<Literal>& eliminationStack, PartialValuation& model);
+
+private:
+    /**
+     * @brief c_maxResolutions - variables whose positive and negative occurrence counts
+     * have a bigger product than this aren't eliminated, resolving them would take too long
+     */
+    static const std::size_t c_maxResolutions = 400;
+
+    /**
+     * @brief c_maxResolventSize - an elimination which would make a longer clause is abandoned
+     */
+    static const std::size_t c_maxResolventSize = 20;
+
+    /**
+     * @brief c_clauseGrowth - how many more resolvents than removed clauses an elimination may add
+     */
+    static const std::size_t c_clauseGrowth = 0;
+
+    static std::uint64_t signature(const Clause& clause);
+
+    unsigned pushClause(const Clause& clause);
+
+    void removeClause(unsigned clauseIdx);
+
+    /**
+     * @brief touch - marks variables of a changed clause, they are candidates for elimination again
+     */
+    void touch(const Clause& clause);
+
+    /**
+     * @brief strengthen - removes lit from the clause and queues it for subsumption
+     */
+    void strengthen(unsigned clauseIdx, Literal lit);
+
+    /**
+     * @brief assign - records a value found for a variable, fails if it has the opposite one
+     */
+    void assign(Literal lit);
+
+    /**
+     * @brief propagateUnits - removes satisfied clauses and false literals of all queued units
+     */
+    void propagateUnits();
+
+    /**
+     * @brief backwardSubsume - removes or strengthens all clauses subsumed by the given one
+     */
+    void backwardSubsume(unsigned clauseIdx);
+
+    /**
+     * @brief subsumeQueued - runs backwardSubsume on all queued clauses and propagates found units
+     */
+    void subsumeQueued();
+
+    /**
+     * @brief cleanOccurs - drops removed clauses from the occurrence list of lit
+     */
+    std::vector<unsigned>& cleanOccurs(Literal lit);
+
+    /**
+     * @brief mark - marks literals of the clause with a new stamp, which clears all older marks
+     */
+    void mark(const Clause& clause);
+
+    /**
+     * @brief resolve - non-tautological resolvent of the two clauses on var into m_resolvent,
+     * literals of positive have to be marked already, so they're marked once for all negative clauses
+     * @return false if the resolvent is a tautology
+     */
+    bool resolve(const Clause& positive, const Clause& negative, unsigned var);
+
+    /**
+     * @brief eliminate - tries to eliminate var by clause distribution
+     * @return true if var was eliminated
+     */
+    bool eliminate(unsigned var);
+
+    void pushEliminated(const Clause& clause, Literal pivot);
+
+    bool outOfTime();
+
+    std::vector<Clause> m_clauses;
+    std::vector<std::uint64_t> m_signatures;
+    std::vector<char> m_removed;
+
+    // indices of clauses of each literal, indexed by litIndex; removed clauses are dropped lazily
+    std::vector<std::vector<unsigned>> m_occurs;
+
+    std::vector<Tribool> m_values;
+    std::vector<Literal> m_units;
+    std::size_t m_propagated = 0;
+
+    std::vector<char> m_eliminated;
+    std::vector<char> m_frozen;
+    std::vector<Literal> m_eliminationStack;
+
+    std::vector<char> m_touched;
+    std::vector<unsigned> m_touchedVars;
+
+    std::vector<unsigned> m_queue;
+    std::vector<char> m_queued;
+
+    // per literal marks of the clause being checked, a new stamp clears all old marks
+    std::vector<unsigned> m_marks;
+    unsigned m_stamp = 0;
+
+    std::vector<unsigned> m_candidates;
+    Clause m_resolvent;
+    std::vector<Literal> m_resolvents;
+
+    ProofWriter* m_proof;
+    // clause before strengthening, which is deleted from the proof after the strengthened one is added
+    Clause m_proofClause;
+
+    bool m_ok = true;
+
+    std::chrono::steady_clock::time_point m_deadline;
+    unsigned m_steps = 0;
+
+    PreprocessStats m_stats;
+};
+
+#endif // PREPROCESSOR_H
@@ -0,0 +1,86 @@
+#include "proof_writer.h"
+
+#include <utility>
+
+ProofWriter::ProofWriter(std::ostream& out, ProofFormat format, bool flushThread, std::size_t bufferSize)
+    : m_out(out), m_format(format), m_buffer(new char[bufferSize]), m_bufferSize(bufferSize)
+{
+    if (flushThread)
+    {
+        m_spare.reset(new char[bufferSize]);
+        m_spareSize = bufferSize;
+        m_thread = std::thread(&ProofWriter::runFlushThread, this);
+    }
+}
+
+ProofWriter::~ProofWriter()
+{
+    finish();
+}
+
+void ProofWriter::flushBuffer()
+{
+    if (m_used == 0)
+    {
+        return;
+    }
+    m_written += m_used;
+    if (!m_thread.joinable())
+    {
+        m_out.write(m_buffer.get(), m_used);
+        m_used = 0;
+        return;
+    }
+
+    {
+        // the spare buffer is free once the thread has written it
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]() { return m_pending == 0; });
+        m_buffer.swap(m_spare);
+        std::swap(m_bufferSize, m_spareSize);
+        m_pending = m_used;
+    }
+    m_changed.notify_all();
+    m_used = 0;
+}
+
+void ProofWriter::runFlushThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_changed.wait(lock, [this]() { return m_pending > 0 || m_stopping; });
+        if (m_pending == 0)
+        {
+            return;
+        }
+
+        // the solver doesn't touch the spare buffer while there's something pending in it
+        std::size_t pending = m_pending;
+        lock.unlock();
+        m_out.write(m_spare.get(), pending);
+        lock.lock();
+        m_pending = 0;
+        m_changed.notify_all();
+    }
+}
+
+void ProofWriter::finish()
+{
+    if (m_finished)
+    {
+        return;
+    }
+    m_finished = true;
+    flushBuffer();
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+    }
+    m_out.flush();
+}
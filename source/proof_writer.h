@@ -0,0 +1,208 @@
+#ifndef PROOF_WRITER_H
+#define PROOF_WRITER_H
+
+#include "choice.h"
+
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+
+/**
+ * @brief The ProofFormat enum - encoding of DRAT proof lines
+ */
+enum class ProofFormat
+{
+    // "a"/"d" and variable-length literals 2*var+sign, as read by drat-trim with -f binary
+    Binary,
+    // "1 -2 0" for additions and "d 1 -2 0" for deletions
+    Text
+};
+
+/**
+ * @brief The ProofWriter class - writes a DRAT proof of unsatisfiability: every clause the
+ * solver adds to the formula, and every clause it deletes from it.
+ *
+ * @details Lines are encoded straight into a large buffer, which goes to the stream only when
+ * it's full. With a flush thread the full buffer is swapped with a second one and written by
+ * the thread, so the solver only waits if the thread hasn't written the previous buffer yet.
+ */
+class ProofWriter
+{
+public:
+    /**
+     * @param out - must stay alive until finish is called or the writer is destroyed
+     * @param flushThread - whether full buffers are written by a separate thread
+     */
+    ProofWriter(std::ostream& out, ProofFormat format = ProofFormat::Binary,
+                bool flushThread = false, std::size_t bufferSize = c_defaultBufferSize);
+
+    ~ProofWriter();
+
+    ProofWriter(const ProofWriter&) = delete;
+    ProofWriter& operator=(const ProofWriter&) = delete;
+
+    /**
+     * @brief add - the clause was added, it has to follow from the formula by unit propagation
+     */
+    template <typename Literals>
+    void add(const Literals& clause)
+    {
+        m_additions++;
+        write(false, clause);
+    }
+
+    /**
+     * @brief remove - the clause was deleted from the formula
+     */
+    template <typename Literals>
+    void remove(const Literals& clause)
+    {
+        m_deletions++;
+        write(true, clause);
+    }
+
+    /**
+     * @brief finish - writes out everything buffered and stops the flush thread,
+     * nothing may be added after it
+     */
+    void finish();
+
+    unsigned long long additions() const
+    {
+        return m_additions;
+    }
+
+    unsigned long long deletions() const
+    {
+        return m_deletions;
+    }
+
+    /**
+     * @brief bytes - size of the proof written so far, including what's still buffered
+     */
+    unsigned long long bytes() const
+    {
+        return m_written + m_used;
+    }
+
+    static const std::size_t c_defaultBufferSize = 1 << 22;
+
+private:
+    /**
+     * @brief c_maxLiteralBytes - longest encoding of one literal, "-2147483647 " in text
+     */
+    static const std::size_t c_maxLiteralBytes = 12;
+
+    template <typename Literals>
+    void write(bool deletion, const Literals& clause)
+    {
+        reserve((clause.size() + 2) * c_maxLiteralBytes);
+        char* pos = m_buffer.get() + m_used;
+        if (m_format == ProofFormat::Binary)
+        {
+            *pos++ = deletion ? 'd' : 'a';
+            for (Literal l : clause)
+            {
+                pos = encodeBinary(pos, l);
+            }
+            *pos++ = 0;
+        }
+        else
+        {
+            if (deletion)
+            {
+                *pos++ = 'd';
+                *pos++ = ' ';
+            }
+            for (Literal l : clause)
+            {
+                pos = encodeText(pos, l);
+            }
+            *pos++ = '0';
+            *pos++ = '\n';
+        }
+        m_used = pos - m_buffer.get();
+    }
+
+    static char* encodeBinary(char* pos, Literal l)
+    {
+        unsigned value = 2 * static_cast<unsigned>(std::abs(l)) + (l < 0);
+        while (value > 127)
+        {
+            *pos++ = static_cast<char>((value & 127) | 128);
+            value >>= 7;
+        }
+        *pos++ = static_cast<char>(value);
+        return pos;
+    }
+
+    static char* encodeText(char* pos, Literal l)
+    {
+        if (l < 0)
+        {
+            *pos++ = '-';
+        }
+        unsigned value = std::abs(l);
+        char digits[10];
+        int count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count)
+        {
+            *pos++ = digits[--count];
+        }
+        *pos++ = ' ';
+        return pos;
+    }
+
+    /**
+     * @brief reserve - makes room for bytes more bytes in the buffer, flushing it if needed
+     */
+    void reserve(std::size_t bytes)
+    {
+        if (m_used + bytes > m_bufferSize)
+        {
+            flushBuffer();
+            if (bytes > m_bufferSize)
+            {
+                m_buffer.reset(new char[bytes]);
+                m_bufferSize = bytes;
+            }
+        }
+    }
+
+    void flushBuffer();
+
+    void runFlushThread();
+
+    std::ostream& m_out;
+    ProofFormat m_format;
+
+    // not a vector, so that the pages aren't cleared and touched before they're needed
+    std::unique_ptr<char[]> m_buffer;
+    std::size_t m_bufferSize;
+    std::size_t m_used = 0;
+
+    // the buffer being written by the flush thread, m_pending bytes of it
+    std::unique_ptr<char[]> m_spare;
+    std::size_t m_spareSize = 0;
+    std::size_t m_pending = 0;
+    bool m_stopping = false;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::thread m_thread;
+
+    bool m_finished = false;
+    unsigned long long m_written = 0;
+    unsigned long long m_additions = 0;
+    unsigned long long m_deletions = 0;
+};
+
+#endif // PROOF_WRITER_H
@@ -0,0 +1,26 @@
+#include "resource_usage.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define HAS_GETRUSAGE
+#endif
+
+double peakMemoryMegabytes()
+{
+#ifdef HAS_GETRUSAGE
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    // bytes on macOS
+    return usage.ru_maxrss / 1e6;
+#else
+    // kilobytes on Linux and the BSDs
+    return usage.ru_maxrss / 1e3;
+#endif
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,10 @@
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+/**
+ * @brief peakMemoryMegabytes - the largest resident set size the process had so far,
+ * 0 on systems where it can't be read
+ */
+double peakMemoryMegabytes();
+
+#endif // RESOURCE_USAGE_H
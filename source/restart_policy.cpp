@@ -0,0 +1,66 @@
+#include "restart_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr double LubyRestarts::c_unit;
+constexpr double GeometricRestarts::c_first;
+constexpr double GeometricRestarts::c_factor;
+constexpr double GlucoseRestarts::c_fastAlpha;
+constexpr double GlucoseRestarts::c_slowAlpha;
+constexpr double GlucoseRestarts::c_margin;
+
+std::unique_ptr<RestartPolicy> RestartPolicy::create(RestartStrategy strategy)
+{
+    switch (strategy)
+    {
+    case RestartStrategy::Luby:
+        return std::unique_ptr<RestartPolicy>(new LubyRestarts());
+    case RestartStrategy::Geometric:
+        return std::unique_ptr<RestartPolicy>(new GeometricRestarts());
+    case RestartStrategy::Glucose:
+        return std::unique_ptr<RestartPolicy>(new GlucoseRestarts());
+    case RestartStrategy::None:
+    default:
+        return std::unique_ptr<RestartPolicy>(new NoRestarts());
+    }
+}
+
+void ConflictLimitRestarts::onRestart()
+{
+    m_conflicts = 0;
+    m_limit = nextLimit();
+}
+
+double LubyRestarts::luby(unsigned i)
+{
+    // find the finite subsequence that contains index i, and its size
+    unsigned size = 1;
+    unsigned seq = 0;
+    while (size < i + 1)
+    {
+        seq++;
+        size = 2 * size + 1;
+    }
+
+    while (size - 1 != i)
+    {
+        size = (size - 1) / 2;
+        seq--;
+        i = i % size;
+    }
+
+    return std::pow(2.0, seq);
+}
+
+void GlucoseRestarts::onConflict(unsigned lbd)
+{
+    m_conflicts++;
+    m_sinceRestart++;
+
+    // until the averages warm up, they are plain means of the values seen so far
+    double fastAlpha = std::max(c_fastAlpha, 1.0 / m_conflicts);
+    double slowAlpha = std::max(c_slowAlpha, 1.0 / m_conflicts);
+    m_fast += fastAlpha * (lbd - m_fast);
+    m_slow += slowAlpha * (lbd - m_slow);
+}
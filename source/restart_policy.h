@@ -0,0 +1,181 @@
+#ifndef RESTART_POLICY_H
+#define RESTART_POLICY_H
+
+#include <memory>
+
+/**
+ * @brief The RestartStrategy enum - restart policies which the solver can be configured with
+ */
+enum class RestartStrategy
+{
+    None,
+    Luby,
+    Geometric,
+    Glucose
+};
+
+/**
+ * @brief The RestartPolicy class - decides when the solver should restart the search.
+ *
+ * @details The solver reports every conflict with the LBD of the learned clause, asks
+ * shouldRestart before each decision and calls onRestart after backtracking to level 0.
+ */
+class RestartPolicy
+{
+public:
+    virtual ~RestartPolicy() = default;
+
+    virtual void onConflict(unsigned lbd) = 0;
+
+    virtual bool shouldRestart() const = 0;
+
+    virtual void onRestart() = 0;
+
+    /**
+     * @brief create - makes the policy for the given strategy
+     */
+    static std::unique_ptr<RestartPolicy> create(RestartStrategy strategy);
+};
+
+/**
+ * @brief The NoRestarts class - never restarts
+ */
+class NoRestarts : public RestartPolicy
+{
+public:
+    void onConflict(unsigned) override
+    {
+    }
+
+    bool shouldRestart() const override
+    {
+        return false;
+    }
+
+    void onRestart() override
+    {
+    }
+};
+
+/**
+ * @brief The ConflictLimitRestarts class - restarts after a number of conflicts which is
+ * recomputed on every restart, base class of the Luby and geometric policies
+ */
+class ConflictLimitRestarts : public RestartPolicy
+{
+public:
+    void onConflict(unsigned) override
+    {
+        m_conflicts++;
+    }
+
+    bool shouldRestart() const override
+    {
+        return m_conflicts >= m_limit;
+    }
+
+    void onRestart() override;
+
+protected:
+    ConflictLimitRestarts(double limit) : m_conflicts(0), m_limit(limit)
+    {
+    }
+
+    virtual double nextLimit() = 0;
+
+private:
+    unsigned long long m_conflicts;
+    double m_limit;
+};
+
+/**
+ * @brief The LubyRestarts class - limits follow the Luby sequence 1, 1, 2, 1, 1, 2, 4, ...
+ * multiplied by c_unit conflicts
+ */
+class LubyRestarts : public ConflictLimitRestarts
+{
+public:
+    LubyRestarts() : ConflictLimitRestarts(c_unit * luby(0)), m_restarts(0)
+    {
+    }
+
+    /**
+     * @brief luby - i-th element (from 0) of the Luby sequence
+     */
+    static double luby(unsigned i);
+
+protected:
+    double nextLimit() override
+    {
+        return c_unit * luby(++m_restarts);
+    }
+
+private:
+    static constexpr double c_unit = 100;
+
+    unsigned m_restarts;
+};
+
+/**
+ * @brief The GeometricRestarts class - every limit is c_factor times bigger than the last one
+ */
+class GeometricRestarts : public ConflictLimitRestarts
+{
+public:
+    GeometricRestarts() : ConflictLimitRestarts(c_first), m_current(c_first)
+    {
+    }
+
+protected:
+    double nextLimit() override
+    {
+        return m_current *= c_factor;
+    }
+
+private:
+    static constexpr double c_first = 100;
+    static constexpr double c_factor = 1.5;
+
+    double m_current;
+};
+
+/**
+ * @brief The GlucoseRestarts class - restarts when LBDs of recently learned clauses get worse
+ * than the long term average.
+ *
+ * @details Both averages are exponential moving averages, the fast one follows the last few
+ * dozen conflicts and the slow one the last few thousand.
+ */
+class GlucoseRestarts : public RestartPolicy
+{
+public:
+    GlucoseRestarts() : m_fast(0), m_slow(0), m_conflicts(0), m_sinceRestart(0)
+    {
+    }
+
+    void onConflict(unsigned lbd) override;
+
+    bool shouldRestart() const override
+    {
+        return m_sinceRestart >= c_minConflicts && m_fast * c_margin > m_slow;
+    }
+
+    void onRestart() override
+    {
+        m_sinceRestart = 0;
+    }
+
+private:
+    static constexpr double c_fastAlpha = 1.0 / 32;
+    static constexpr double c_slowAlpha = 1.0 / 4096;
+    // restart when the fast average is 25% above the slow one
+    static constexpr double c_margin = 0.8;
+    static const unsigned c_minConflicts = 50;
+
+    double m_fast;
+    double m_slow;
+    unsigned long long m_conflicts;
+    unsigned long long m_sinceRestart;
+};
+
+#endif // RESTART_POLICY_H
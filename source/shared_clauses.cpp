@@ -0,0 +1,29 @@
+#include "shared_clauses.h"
+#include "partial_valuation.h"
+
+SharedClauses::SharedClauses(const DimacsFormula& formula)
+    : m_varCount(formula.varCount), m_stats(formula.stats)
+{
+    m_clauses.reserve(formula.clauseCount);
+    // every clause has a 0 after its literals in the formula, and a header in the arena instead
+    m_arena.reserve(formula.literals.size() + formula.clauseCount * (ArenaClause::c_headerWords - 1));
+
+    Clause clause;
+    for (Literal lit : formula.literals)
+    {
+        if (lit != NullLiteral)
+        {
+            clause.push_back(lit);
+            continue;
+        }
+        if (clause.empty())
+        {
+            m_hasEmptyClause = true;
+        }
+        else
+        {
+            m_clauses.push_back(m_arena.alloc(clause, false) | c_sharedClause);
+        }
+        clause.clear();
+    }
+}
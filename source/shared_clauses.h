@@ -0,0 +1,81 @@
+#ifndef SHARED_CLAUSES_H
+#define SHARED_CLAUSES_H
+
+#include "clause_arena.h"
+#include "dimacs_parser.h"
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief The SharedClauses class - original clauses of a formula stored once and only read
+ * afterwards, so that solvers in several threads can work on the same copy.
+ *
+ * @details A solver refers to a shared clause by its offset in the arena with c_sharedClause
+ * set. Literals of a shared clause are never moved, the solver keeps its own two watched
+ * literals for it in a table indexed by watchSlot.
+ */
+class SharedClauses
+{
+public:
+    /**
+     * @param formula - isn't needed after the constructor
+     */
+    explicit SharedClauses(const DimacsFormula& formula);
+
+    unsigned varCount() const
+    {
+        return m_varCount;
+    }
+
+    /**
+     * @brief clauses - indices of all the clauses, the empty one isn't stored
+     */
+    const std::vector<ClauseIndex>& clauses() const
+    {
+        return m_clauses;
+    }
+
+    /**
+     * @brief hasEmptyClause - whether the formula contains the empty clause, so it is UNSAT
+     */
+    bool hasEmptyClause() const
+    {
+        return m_hasEmptyClause;
+    }
+
+    const LoadStats& stats() const
+    {
+        return m_stats;
+    }
+
+    const ArenaClause operator[](ClauseIndex clauseIdx) const
+    {
+        return m_arena[clauseIdx & ~c_sharedClause];
+    }
+
+    /**
+     * @brief watchSlot - position of the clause in a table with watchSlots entries; clauses
+     * with more than 2 literals take at least c_slotWords words, so each of them gets its own
+     */
+    static std::size_t watchSlot(ClauseIndex clauseIdx)
+    {
+        return (clauseIdx & ~c_sharedClause) / c_slotWords;
+    }
+
+    std::size_t watchSlots() const
+    {
+        return m_arena.size() / c_slotWords + 1;
+    }
+
+private:
+    static const unsigned c_slotWords = ArenaClause::c_headerWords + 3;
+
+    ClauseArena m_arena;
+    std::vector<ClauseIndex> m_clauses;
+    unsigned m_varCount;
+    bool m_hasEmptyClause = false;
+    LoadStats m_stats;
+};
+
+#endif // SHARED_CLAUSES_H
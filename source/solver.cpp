@@ -1,355 +1,1700 @@
 #include "solver.h"
+#include "resource_usage.h"
 
-#include <set>
+#include <algorithm>
 #include <string>
-#include <sstream>
 #include <stdexcept>
-#include <iterator>
+#include <chrono>
+#include <functional>
+#include <sstream>
+
+
+const char* stopReasonName(StopReason reason)
+{
+    switch (reason)
+    {
+    case StopReason::Finished:
+        return "finished";
+    case StopReason::Interrupted:
+        return "interrupted";
+    case StopReason::ConflictBudget:
+        return "conflicts";
+    case StopReason::PropagationBudget:
+        return "propagations";
+    case StopReason::TimeBudget:
+        return "time";
+    default:
+        return "memory";
+    }
+}
+
+SolveHandle& SolveHandle::operator=(SolveHandle&& other)
+{
+    if (this != &other)
+    {
+        if (valid())
+        {
+            cancel();
+            wait();
+        }
+        m_cancelled = std::move(other.m_cancelled);
+        m_result = std::move(other.m_result);
+    }
+    return *this;
+}
+
+SolveHandle::~SolveHandle()
+{
+    if (valid())
+    {
+        cancel();
+        wait();
+    }
+}
+
+bool SolveHandle::ready() const
+{
+    return m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void SolveHandle::cancel()
+{
+    if (m_cancelled)
+    {
+        m_cancelled->store(true, std::memory_order_relaxed);
+    }
+}
+
+SolveResult SolveHandle::get()
+{
+    return m_result.get();
+}
+
+void Solver::analyze(ClauseIndex conflict, Clause& learned, unsigned& backjumpLevel)
+{
+    const std::vector<Literal>& stack = m_valuation.stack();
+    const unsigned currentLevel = m_valuation.currentLevel();
+
+    learned.clear();
+    // place for the negation of the first UIP
+    learned.push_back(NullLiteral);
+
+    // number of seen literals from the current level which are still to be resolved
+    int pathCount = 0;
+    Literal uip = NullLiteral;
+    int index = stack.size() - 1;
+
+    do
+    {
+        ArenaClause clause = this->clause(conflict);
+        if (clause.learned())
+        {
+            bumpClauseActivity(clause);
+        }
+        for (Literal l : clause)
+        {
+            unsigned var = std::abs(l);
+            // the literal implied by the reason clause is the one being resolved on
+            if (uip != NullLiteral && var == static_cast<unsigned>(std::abs(uip)))
+            {
+                continue;
+            }
+            // literals from level 0 are false forever, no need to keep them
+            if (!m_seen[var] && m_valuation.level(var) > 0)
+            {
+                m_seen[var] = 1;
+                m_valuation.bumpWeight(l);
+                if (m_valuation.level(var) >= currentLevel)
+                {
+                    pathCount++;
+                }
+                else
+                {
+                    learned.push_back(l);
+                }
+            }
+        }
+
+        // next seen literal on the stack is resolved with its reason
+        while (!m_seen[std::abs(stack[index])])
+        {
+            index--;
+        }
+        uip = stack[index];
+        conflict = m_valuation.reason(std::abs(uip));
+        m_seen[std::abs(uip)] = 0;
+        pathCount--;
+        index--;
+    } while (pathCount > 0);
+
+    learned[0] = -uip;
+    m_learnStats.clauses++;
+    m_learnStats.literalsBeforeMinimization += learned.size();
+
+    minimize(learned);
+    m_learnStats.literalsAfterMinimization += learned.size();
+
+    // the literal with the highest level goes to position 1, it will be watched with the UIP
+    backjumpLevel = 0;
+    for (unsigned i = 1; i < learned.size(); i++)
+    {
+        unsigned level = m_valuation.level(std::abs(learned[i]));
+        if (level > backjumpLevel)
+        {
+            backjumpLevel = level;
+            std::swap(learned[1], learned[i]);
+        }
+    }
+}
+
+void Solver::minimize(Clause& learned)
+{
+    // seen flags of the learned literals are still set, they have to be cleared at the end
+    m_analyzeToClear.assign(learned.begin(), learned.end());
+
+    // levels of the clause as a bit set, a literal implied only by literals from
+    // levels outside of it can't be redundant
+    uint32_t levels = 0;
+    for (unsigned i = 1; i < learned.size(); i++)
+    {
+        levels |= abstractLevel(std::abs(learned[i]));
+    }
+
+    unsigned j = 1;
+    for (unsigned i = 1; i < learned.size(); i++)
+    {
+        unsigned var = std::abs(learned[i]);
+        if (m_valuation.reason(var) == NullClause || !isRedundant(learned[i], levels))
+        {
+            learned[j++] = learned[i];
+        }
+    }
+    learned.resize(j);
+
+    for (Literal l : m_analyzeToClear)
+    {
+        m_seen[std::abs(l)] = 0;
+    }
+}
+
+bool Solver::isRedundant(Literal lit, uint32_t levels)
+{
+    m_analyzeStack.clear();
+    m_analyzeStack.push_back(lit);
+    const unsigned top = m_analyzeToClear.size();
+
+    while (!m_analyzeStack.empty())
+    {
+        unsigned implied = std::abs(m_analyzeStack.back());
+        m_analyzeStack.pop_back();
+
+        ArenaClause reason = clause(m_valuation.reason(implied));
+        for (Literal l : reason)
+        {
+            unsigned var = std::abs(l);
+            if (var == implied || m_seen[var] || m_valuation.level(var) == 0)
+            {
+                continue;
+            }
+
+            if (m_valuation.reason(var) != NullClause && (abstractLevel(var) & levels))
+            {
+                // l is redundant if its own reason is, so check it as well
+                m_seen[var] = 1;
+                m_analyzeStack.push_back(l);
+                m_analyzeToClear.push_back(l);
+            }
+            else
+            {
+                // undo the flags set by this call, they would wrongly mark literals as redundant
+                for (unsigned i = top; i < m_analyzeToClear.size(); i++)
+                {
+                    m_seen[std::abs(m_analyzeToClear[i])] = 0;
+                }
+                m_analyzeToClear.resize(top);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+unsigned Solver::computeLbd(const Clause& clause)
+{
+    // a new stamp marks levels of this clause without clearing the old marks
+    m_lbdStamp++;
+    unsigned lbd = 0;
+    for (Literal l : clause)
+    {
+        unsigned level = m_valuation.level(std::abs(l));
+        if (m_levelStamps[level] != m_lbdStamp)
+        {
+            m_levelStamps[level] = m_lbdStamp;
+            lbd++;
+        }
+    }
+    return lbd;
+}
+
+void Solver::restart()
+{
+    // learned clauses and weights are kept, only decisions are undone
+    backjump(0);
+    m_valuation.resetTargetPhases();
+    m_restarts++;
+    m_restartPolicy->onRestart();
+
+    importClauses();
+}
+
+void Solver::startBudget()
+{
+    m_stopReason = StopReason::Finished;
+    m_conflictStop = m_budget.conflicts ? m_conflicts + m_budget.conflicts : 0;
+    m_propagationStop = m_budget.propagations ? m_propStats.propagations + m_budget.propagations : 0;
+    m_deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_budget.seconds));
+    // the first check looks at the clock
+    m_budgetCountdown = 1;
+}
+
+bool Solver::outOfBudget()
+{
+    if (m_interrupt.load(std::memory_order_relaxed))
+    {
+        m_interrupt.store(false, std::memory_order_relaxed);
+        m_stopReason = StopReason::Interrupted;
+    }
+    else if ((m_terminate && m_terminate->load(std::memory_order_relaxed)) ||
+             (m_cancel && m_cancel->load(std::memory_order_relaxed)))
+    {
+        m_stopReason = StopReason::Interrupted;
+    }
+    else if (m_conflictStop && m_conflicts >= m_conflictStop)
+    {
+        m_stopReason = StopReason::ConflictBudget;
+    }
+    else if (m_propagationStop && m_propStats.propagations >= m_propagationStop)
+    {
+        m_stopReason = StopReason::PropagationBudget;
+    }
+    else if ((m_budget.seconds > 0 || m_budget.memoryMB > 0) && --m_budgetCountdown == 0)
+    {
+        // reading the clock and adding up the watch lists is too slow for every decision
+        m_budgetCountdown = c_budgetCheckInterval;
+        if (m_budget.seconds > 0 && std::chrono::steady_clock::now() >= m_deadline)
+        {
+            m_stopReason = StopReason::TimeBudget;
+        }
+        else if (m_budget.memoryMB > 0 && memoryMegabytes() > m_budget.memoryMB)
+        {
+            m_stopReason = StopReason::MemoryBudget;
+        }
+    }
+    return m_stopReason != StopReason::Finished;
+}
+
+double Solver::memoryMegabytes() const
+{
+    // shared clauses aren't counted, they belong to all the solvers reading them
+    std::size_t bytes = m_formula.size() * sizeof(uint32_t) + m_sharedWatches.capacity() * sizeof(m_sharedWatches[0]);
+    for (const WatchList& watches : m_watches)
+    {
+        bytes += watches.capacity() * sizeof(Watcher);
+    }
+    for (const BinaryList& implications : m_binWatches)
+    {
+        bytes += implications.capacity() * sizeof(BinaryWatcher);
+    }
+    return bytes / 1e6;
+}
+
+void Solver::rephase()
+{
+    static const Rephase schedule[] = {Rephase::Best, Rephase::Inverted, Rephase::Best, Rephase::Original};
+    m_valuation.rephase(schedule[m_rephases % 4]);
+    m_rephases++;
+    m_nextRephase = m_conflicts + c_rephaseInterval * (m_rephases + 1);
+}
+
+void Solver::preprocess()
+{
+    m_preprocessed = true;
+    const unsigned nVars = m_valuation.varCount();
+
+    // units of the input are propagated with the watches first, which is much cheaper than
+    // doing it on occurrence lists, and clauses satisfied by them aren't copied at all
+    if (propagate() != NullClause)
+    {
+        m_ok = false;
+        return;
+    }
+
+    Preprocessor preprocessor(nVars, m_proof);
+    for (Literal assumption : m_assumptions)
+    {
+        preprocessor.freeze(std::abs(assumption));
+    }
+    Clause clause;
+    for (Literal unit : m_valuation.stack())
+    {
+        clause.assign(1, unit);
+        preprocessor.addClause(clause);
+        if (m_proof)
+        {
+            // clauses which implied the unit may be removed below
+            m_proof->add(clause);
+        }
+    }
+    for (ClauseIndex clauseIdx : m_clauses)
+    {
+        clause.clear();
+        bool satisfied = false;
+        for (Literal l : this->clause(clauseIdx))
+        {
+            if (m_valuation.isLiteralTrue(l))
+            {
+                satisfied = true;
+                break;
+            }
+            if (m_valuation.isLiteralUndefined(l))
+            {
+                clause.push_back(l);
+            }
+        }
+        if (!satisfied)
+        {
+            preprocessor.addClause(clause);
+        }
+        if (m_proof && (satisfied || clause.size() < this->clause(clauseIdx).size()))
+        {
+            // the preprocessor only knows the clause without its false literals
+            if (!satisfied)
+            {
+                m_proof->add(clause);
+            }
+            m_proof->remove(this->clause(clauseIdx));
+        }
+    }
+    m_ok = preprocessor.run(c_preprocessTimeLimit);
+    m_preprocessStats = preprocessor.stats();
+    if (!m_ok)
+    {
+        return;
+    }
+
+    // nothing was decided or learned yet, so the simplified formula is loaded from scratch
+    ClauseArena().swap(m_formula);
+    m_shared = nullptr;
+    std::vector<Literal>().swap(m_sharedWatches);
+    m_clauses.clear();
+    for (WatchList& watches : m_watches)
+    {
+        watches.clear();
+    }
+    for (BinaryList& implications : m_binWatches)
+    {
+        implications.clear();
+    }
+    m_valuation.unassignAll();
+    m_propagated = 0;
+
+    for (unsigned var = 1; var <= nVars; var++)
+    {
+        if (preprocessor.isEliminated(var))
+        {
+            m_valuation.eliminate(var);
+        }
+    }
+    for (const Clause& simplified : preprocessor.takeClauses())
+    {
+        watchTwoLiterals(addClause(simplified, false));
+    }
+    m_eliminationStack = preprocessor.takeEliminationStack();
+}
+
+void Solver::inprocess()
+{
+    // both techniques start from the root level, which is a restart for the search
+    backjump(0);
+    m_inprocessStats.rounds++;
+
+    auto start = std::chrono::steady_clock::now();
+    probe();
+    auto probed = std::chrono::steady_clock::now();
+    m_inprocessStats.probeSeconds += std::chrono::duration<double>(probed - start).count();
+
+    if (m_ok)
+    {
+        vivify();
+        m_inprocessStats.vivifySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - probed).count();
+    }
+    m_nextInprocess = m_conflicts + c_inprocessInterval;
+}
+
+bool Solver::learnUnit(Literal lit)
+{
+    // the unit is kept as a learned clause, so it's the reason of lit like any other
+    Clause clause{lit};
+    if (m_proof)
+    {
+        m_proof->add(clause);
+    }
+    ClauseIndex unit = addClause(clause, true);
+    m_formula[unit].setLbd(1);
+    if (m_sharing)
+    {
+        m_sharing->exportClause(clause, 1);
+        m_exportedClauses++;
+    }
+    m_valuation.push(lit, unit);
+    if (propagate() != NullClause)
+    {
+        m_ok = false;
+    }
+    return m_ok;
+}
+
+void Solver::probe()
+{
+    const unsigned nVars = m_valuation.varCount();
+    unsigned probes = 0;
+    for (unsigned i = 0; i < nVars && probes < c_probeLimit; i++)
+    {
+        unsigned var = m_nextProbe;
+        m_nextProbe = m_nextProbe % nVars + 1;
+        if (m_valuation.isEliminated(var))
+        {
+            continue;
+        }
+
+        for (Literal lit : {static_cast<Literal>(var), -static_cast<Literal>(var)})
+        {
+            // a root implies other literals through binary clauses, but isn't implied by any,
+            // so probing it covers everything it implies
+            if (!m_valuation.isLiteralUndefined(lit) ||
+                    !m_binWatches[litIndex(lit)].empty() || m_binWatches[litIndex(-lit)].empty())
+            {
+                continue;
+            }
+
+            probes++;
+            m_valuation.push(lit, true);
+            ClauseIndex conflict = propagate();
+            // values tried out by probing aren't worth remembering as phases
+            backjump(0, false);
+
+            if (conflict != NullClause)
+            {
+                m_inprocessStats.failedLiterals++;
+                if (!learnUnit(-lit))
+                {
+                    m_inprocessStats.probes += probes;
+                    return;
+                }
+            }
+        }
+    }
+    m_inprocessStats.probes += probes;
+}
+
+void Solver::vivify()
+{
+    std::vector<ClauseIndex> candidates;
+    for (ClauseIndex clauseIdx : m_learned)
+    {
+        ArenaClause clause = m_formula[clauseIdx];
+        if (!clause.deleted() && !clause.vivified() && clause.size() > 2)
+        {
+            candidates.push_back(clauseIdx);
+        }
+    }
+
+    // the best clauses stay in the database the longest, shortening them pays off the most
+    std::size_t count = std::min(candidates.size(), c_vivifyLimit);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), [this](ClauseIndex a, ClauseIndex b){
+        ArenaClause ca = m_formula[a];
+        ArenaClause cb = m_formula[b];
+        if (ca.lbd() != cb.lbd())
+        {
+            return ca.lbd() < cb.lbd();
+        }
+        return ca.activity() > cb.activity();
+    });
+    candidates.resize(count);
+
+    for (ClauseIndex clauseIdx : candidates)
+    {
+        if (!vivifyClause(clauseIdx))
+        {
+            return;
+        }
+    }
+}
+
+bool Solver::vivifyClause(ClauseIndex clauseIdx)
+{
+    // units found so far may have made the clause a reason at level 0
+    if (isLocked(clauseIdx))
+    {
+        return true;
+    }
+    m_formula[clauseIdx].setVivified();
+    m_inprocessStats.vivifiedClauses++;
+
+    // propagation moves literals of the clause around while it's watched, so they're copied
+    ArenaClause original = m_formula[clauseIdx];
+    m_vivifyLits.assign(original.begin(), original.end());
+    const unsigned size = m_vivifyLits.size();
+    m_vivified.clear();
+    bool satisfied = false;
+    ClauseIndex conflict = NullClause;
+    for (unsigned i = 0; i < size && conflict == NullClause; i++)
+    {
+        Literal lit = m_vivifyLits[i];
+        if (m_valuation.isLiteralTrue(lit))
+        {
+            // true at level 0 for good, or implied by negations of the literals before it
+            satisfied = m_valuation.level(std::abs(lit)) == 0;
+            m_vivified.push_back(lit);
+            break;
+        }
+        if (!m_valuation.isLiteralUndefined(lit))
+        {
+            // false at level 0, or implied false by negations of the literals before it
+            continue;
+        }
+
+        m_vivified.push_back(lit);
+        if (i + 1 < size)
+        {
+            m_valuation.push(-lit, true);
+            conflict = propagate();
+        }
+    }
+    backjump(0, false);
+
+    if (satisfied)
+    {
+        removeClause(clauseIdx);
+        return true;
+    }
+    if (m_vivified.size() == size)
+    {
+        return true;
+    }
+
+    m_inprocessStats.shortenedClauses++;
+    m_inprocessStats.removedLiterals += size - m_vivified.size();
+    unsigned lbd = std::min<unsigned>(m_formula[clauseIdx].lbd(), m_vivified.size());
+    float activity = m_formula[clauseIdx].activity();
+    if (m_proof && m_vivified.size() > 1)
+    {
+        // the shortened clause follows from the original one, so it's logged before the deletion
+        m_proof->add(m_vivified);
+    }
+    removeClause(clauseIdx);
+
+    if (m_vivified.size() == 1)
+    {
+        return learnUnit(m_vivified[0]);
+    }
+    ClauseIndex shortened = addClause(m_vivified, true);
+    ArenaClause clause = m_formula[shortened];
+    clause.setLbd(lbd);
+    clause.setActivity(activity);
+    clause.setVivified();
+    watchTwoLiterals(shortened);
+    return true;
+}
+
+void Solver::importClauses()
+{
+    if (!m_sharing)
+    {
+        return;
+    }
+    m_imported.clear();
+    m_sharing->importClauses(m_imported);
+
+    Clause clause;
+    for (std::size_t i = 0; i < m_imported.size() && m_ok; i++)
+    {
+        unsigned lbd = m_imported[i++];
+        clause.clear();
+        bool satisfied = false;
+        // literals false at level 0 are left out, and clauses with eliminated
+        // variables are dropped, this solver doesn't have them any more
+        for (; m_imported[i] != NullLiteral; i++)
+        {
+            Literal lit = m_imported[i];
+            if (m_valuation.isEliminated(std::abs(lit)) || m_valuation.isLiteralTrue(lit))
+            {
+                satisfied = true;
+            }
+            else if (m_valuation.isLiteralUndefined(lit))
+            {
+                clause.push_back(lit);
+            }
+        }
+        if (satisfied)
+        {
+            continue;
+        }
+
+        m_importedClauses++;
+        if (clause.empty())
+        {
+            m_ok = false;
+        }
+        else if (clause.size() == 1)
+        {
+            // not exported again, every other solver got it already
+            ClauseIndex unit = addClause(clause, true);
+            m_formula[unit].setLbd(1);
+            m_valuation.push(clause[0], unit);
+            m_ok = propagate() == NullClause;
+        }
+        else
+        {
+            ClauseIndex clauseIdx = addClause(clause, true);
+            m_formula[clauseIdx].setLbd(std::min<unsigned>(lbd, clause.size()));
+            watchTwoLiterals(clauseIdx);
+        }
+    }
+}
+
+Lookahead Solver::lookahead(const std::vector<Literal>& cube)
+{
+    Lookahead result;
+    backjump(0);
+    if (m_ok && propagate() != NullClause)
+    {
+        m_ok = false;
+    }
+    if (!m_ok)
+    {
+        result.refuted = true;
+        return result;
+    }
+
+    // the cube is decided one literal per level, like assumptions
+    for (Literal lit : cube)
+    {
+        if (m_valuation.isLiteralTrue(lit))
+        {
+            continue;
+        }
+        if (!m_valuation.isLiteralUndefined(lit))
+        {
+            result.refuted = true;
+            break;
+        }
+        m_valuation.push(lit, true);
+        if (propagate() != NullClause)
+        {
+            result.refuted = true;
+            break;
+        }
+    }
+    if (result.refuted)
+    {
+        backjump(0, false);
+        return result;
+    }
+    const unsigned base = m_valuation.stackSize();
+    result.assigned = base;
+
+    // variables in many clauses are the likeliest to propagate a lot
+    const unsigned nVars = m_valuation.varCount();
+    std::vector<std::pair<std::size_t, unsigned>> candidates;
+    for (unsigned var = 1; var <= nVars; var++)
+    {
+        Literal lit = var;
+        if (m_valuation.isLiteralUndefined(lit) && !m_valuation.isEliminated(var))
+        {
+            std::size_t occurrences = m_watches[litIndex(lit)].size() + m_watches[litIndex(-lit)].size() +
+                    m_binWatches[litIndex(lit)].size() + m_binWatches[litIndex(-lit)].size();
+            candidates.push_back({occurrences, var});
+        }
+    }
+    std::size_t count = std::min(candidates.size(), c_lookaheadCandidates);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      std::greater<std::pair<std::size_t, unsigned>>());
+
+    const unsigned level = m_valuation.currentLevel();
+    unsigned long long bestScore = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        Literal var = candidates[i].second;
+        unsigned long long score = 1;
+        bool failed = false;
+        for (Literal lit : {var, -var})
+        {
+            m_valuation.push(lit, true);
+            failed = propagate() != NullClause;
+            score *= m_valuation.stackSize() - base;
+            backjump(level, false);
+            if (failed)
+            {
+                break;
+            }
+        }
+        // a failed literal refutes one half of the split right away, there's no better branch
+        if (failed)
+        {
+            result.branch = var;
+            break;
+        }
+        if (score > bestScore)
+        {
+            bestScore = score;
+            result.branch = var;
+        }
+    }
+
+    backjump(0, false);
+    return result;
+}
+
+void Solver::setSeed(unsigned seed)
+{
+    m_valuation.randomizeOrder(seed);
+}
+
+void Solver::setInitialPhase(bool positive)
+{
+    m_valuation.rephase(positive ? Rephase::Original : Rephase::Inverted);
+}
+
+void Solver::setRestartStrategy(RestartStrategy strategy)
+{
+    m_restartPolicy = RestartPolicy::create(strategy);
+}
+
+bool Solver::learnClause(ClauseIndex conflict)
+{
+    if (conflict == NullClause)
+    {
+        throw std::runtime_error("Delete this: bug - conflict clause is null");
+    }
+    if (m_valuation.currentLevel() == 0)
+    {
+        // conflict without any decision => UNSAT
+        return true;
+    }
+
+    // Find the cut in the implication graph that led to the conflict
+    unsigned backjumpLevel;
+    analyze(conflict, m_learnedClause, backjumpLevel);
+    if (m_proof)
+    {
+        m_proof->add(m_learnedClause);
+    }
+    unsigned lbd = computeLbd(m_learnedClause);
+    ArenaClause learned = m_formula[addClause(m_learnedClause, true)];
+    learned.setLbd(lbd);
+    if (m_sharing && (lbd <= c_exportLbd || m_learnedClause.size() <= c_exportSize))
+    {
+        m_sharing->exportClause(m_learnedClause, lbd);
+        m_exportedClauses++;
+    }
+    bumpClauseActivity(learned);
+    m_restartPolicy->onConflict(lbd);
+    m_conflicts++;
+    m_clauseIncrement /= c_clauseDecayFactor;
+
+    if (UseTargetPhase || UseRephasing)
+    {
+        m_valuation.updateTargetPhases();
+    }
+
+    // Non-chronologically backtrack ("back jump")
+    backjump(backjumpLevel);
+    return false;
+}
+
+Solver::Solver()
+{
+    load(DimacsFormula());
+}
+
+Solver::Solver(std::istream &dimacsStream)
+{
+    DimacsFormula formula;
+    DimacsParser().parse(dimacsStream, formula);
+    load(formula);
+}
+
+Solver::Solver(const DimacsFormula &formula)
+{
+    load(formula);
+}
+
+Solver::Solver(const SharedClauses &clauses)
+{
+    load(clauses);
+}
+
+void Solver::resetVariables(unsigned nVars)
+{
+    m_valuation.reset(nVars);
+    m_seen.assign(nVars + 1, 0);
+    m_levelStamps.assign(nVars + 2, 0);
+    m_watches.resize(2 * (nVars + 1));
+    m_binWatches.resize(2 * (nVars + 1));
+}
+
+void Solver::load(const DimacsFormula &formula)
+{
+    resetVariables(formula.varCount);
+    m_clauses.reserve(formula.clauseCount + 1000);
+    // every clause has a 0 after its literals in the formula, and a header in the arena instead
+    m_formula.reserve(formula.literals.size() + formula.clauseCount * (ArenaClause::c_headerWords - 1));
+    m_loadStats = formula.stats;
+
+    // clauses were already normalized by the parser, no duplicate literals and no tautologies
+    Clause clause;
+    for (Literal lit : formula.literals)
+    {
+        if (lit != NullLiteral)
+        {
+            clause.push_back(lit);
+            continue;
+        }
+        if (clause.empty())
+        {
+            m_ok = false;
+        }
+        else
+        {
+            watchTwoLiterals(addClause(clause, false));
+        }
+        clause.clear();
+    }
+}
+
+void Solver::load(const SharedClauses &clauses)
+{
+    resetVariables(clauses.varCount());
+    m_shared = &clauses;
+    m_sharedWatches.resize(clauses.watchSlots());
+    m_clauses.reserve(clauses.clauses().size() + 1000);
+    m_loadStats = clauses.stats();
+
+    if (clauses.hasEmptyClause())
+    {
+        m_ok = false;
+    }
+    for (ClauseIndex clauseIdx : clauses.clauses())
+    {
+        m_clauses.push_back(clauseIdx);
+        watchTwoLiterals(clauseIdx);
+    }
+}
+
+void Solver::growVariables(unsigned nVars)
+{
+    if (nVars < m_seen.size())
+    {
+        return;
+    }
+    if (nVars > c_maxVariable)
+    {
+        throw std::runtime_error{"Variable " + std::to_string(nVars) + " is out of the supported range"};
+    }
+    m_valuation.grow(nVars);
+    m_seen.resize(nVars + 1, 0);
+    m_levelStamps.resize(nVars + 2, 0);
+    m_watches.resize(2 * (nVars + 1));
+    m_binWatches.resize(2 * (nVars + 1));
+}
+
+bool Solver::addClause(const Clause& clause)
+{
+    // the previous solve may have left a model or a conflict on the stack
+    backjump(0);
+    for (Literal lit : clause)
+    {
+        growVariables(std::abs(lit));
+    }
+    for (Literal lit : clause)
+    {
+        if (m_valuation.isEliminated(std::abs(lit)))
+        {
+            restoreEliminated(std::abs(lit));
+        }
+    }
+    return addInputClause(clause);
+}
+
+bool Solver::addInputClause(Clause clause)
+{
+    if (!m_ok)
+    {
+        return false;
+    }
+
+    // duplicates and complementary literals end up next to each other
+    std::sort(clause.begin(), clause.end(), [](Literal a, Literal b) {
+        return std::abs(a) != std::abs(b) ? std::abs(a) < std::abs(b) : a < b;
+    });
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < clause.size(); i++)
+    {
+        if (m_valuation.isLiteralTrue(clause[i]) || (i > 0 && clause[i] == -clause[i-1]))
+        {
+            // satisfied at the root level or a tautology
+            return true;
+        }
+        if (m_valuation.isLiteralUndefined(clause[i]))
+        {
+            clause[kept++] = clause[i];
+        }
+    }
+    clause.resize(kept);
+
+    if (clause.empty())
+    {
+        m_ok = false;
+        return false;
+    }
+    watchTwoLiterals(addClause(clause, false));
+    if (clause.size() == 1 && propagate() != NullClause)
+    {
+        m_ok = false;
+    }
+    return m_ok;
+}
+
+void Solver::restoreEliminated(unsigned var)
+{
+    // the stack is read from the end, each clause is followed by its size
+    std::vector<Clause> clauses;
+    std::vector<std::pair<std::size_t, std::size_t>> kept;
+    std::size_t i = m_eliminationStack.size();
+    while (i > 0)
+    {
+        std::size_t size = m_eliminationStack[--i];
+        i -= size;
+        auto begin = m_eliminationStack.begin() + i;
+        if (static_cast<unsigned>(std::abs(*begin)) == var)
+        {
+            // a unit is only the default value of var, not a clause of the formula
+            if (size > 1)
+            {
+                clauses.emplace_back(begin, begin + size);
+            }
+        }
+        else
+        {
+            kept.push_back({i, size});
+        }
+    }
 
+    std::vector<Literal> eliminationStack;
+    eliminationStack.reserve(m_eliminationStack.size());
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it)
+    {
+        auto begin = m_eliminationStack.begin() + it->first;
+        eliminationStack.insert(eliminationStack.end(), begin, begin + it->second);
+        eliminationStack.push_back(it->second);
+    }
+    m_eliminationStack.swap(eliminationStack);
+
+    // the formula without var is its projection, so adding back all clauses of var makes
+    // it equivalent to the original again as far as var is concerned
+    m_valuation.restore(var);
+    for (const Clause& clause : clauses)
+    {
+        // variables eliminated after var may have been in its clauses
+        for (Literal lit : clause)
+        {
+            if (m_valuation.isEliminated(std::abs(lit)))
+            {
+                restoreEliminated(std::abs(lit));
+            }
+        }
+        addInputClause(clause);
+    }
+}
 
-Clause Solver::findResponsibleLiterals(Clause& conflict)
+SolveResult Solver::solve(const std::vector<Literal>& assumptions)
 {
-    Clause reason(conflict);
+    backjump(0);
+    for (Literal lit : assumptions)
+    {
+        growVariables(std::abs(lit));
+        if (m_valuation.isEliminated(std::abs(lit)))
+        {
+            restoreEliminated(std::abs(lit));
+        }
+    }
+    // every assumption may open its own level, even if it's already true
+    m_levelStamps.resize(std::max(m_levelStamps.size(), m_seen.size() + assumptions.size() + 1), 0);
+
+    m_assumptions = assumptions;
+    OptionalPartialValuation solution = solve2();
+    m_assumptions.clear();
+
+    m_model = std::experimental::nullopt;
+    if (solution)
+    {
+        m_model.emplace(std::move(*solution));
+    }
+    return m_status;
+}
 
-    auto& stack = m_valuation.stack();
+SolveHandle Solver::solveAsync(const std::vector<Literal>& assumptions)
+{
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    std::future<SolveResult> result = std::async(std::launch::async, [this, assumptions, cancelled]() {
+        m_cancel = cancelled.get();
+        SolveResult answer = solve(assumptions);
+        m_cancel = nullptr;
+        return answer;
+    });
+    return SolveHandle(std::move(cancelled), std::move(result));
+}
 
-    while(m_valuation.stackSize() && m_valuation.back().hasReason())
+void Solver::analyzeFinal(Literal assumption)
+{
+    m_failedAssumptions.assign(1, assumption);
+    if (m_valuation.level(std::abs(assumption)) == 0)
     {
-        reason = resolution(reason, m_formula[stack.back().reason], stack.back().lit);
-        m_valuation.pop();
+        // the formula alone implies the negation
+        return;
     }
 
-    if (reason == conflict)
+    // only assumptions are decided below their levels, so they are the reasonless literals
+    // found by walking back from the assumption through reasons
+    m_seen[std::abs(assumption)] = 1;
+    const std::vector<Literal>& stack = m_valuation.stack();
+    for (std::size_t i = stack.size(); i > 0; i--)
     {
-        std::cout << "I'm not 100% sure about where to handle this, but it's UNSAT." << std::endl;
-        return Clause();
+        unsigned var = std::abs(stack[i-1]);
+        if (!m_seen[var])
+        {
+            continue;
+        }
+        m_seen[var] = 0;
+
+        ClauseIndex reason = m_valuation.reason(var);
+        if (reason == NullClause)
+        {
+            m_failedAssumptions.push_back(stack[i-1]);
+            continue;
+        }
+        for (Literal l : clause(reason))
+        {
+            unsigned other = std::abs(l);
+            if (other != var && m_valuation.level(other) > 0)
+            {
+                m_seen[other] = 1;
+            }
+        }
     }
+}
 
-    return reason;
+ClauseIndex Solver::addClause(const Clause& clause, bool learned)
+{
+    ClauseIndex clauseIdx = m_formula.alloc(clause, learned);
+    (learned ? m_learned : m_clauses).push_back(clauseIdx);
+    return clauseIdx;
 }
 
-Clause Solver::resolution(Clause& reason, Clause& b, Literal& which) const
+void Solver::removeClause(ClauseIndex clauseIdx)
 {
-    if (reason.end() == std::find(reason.begin(), reason.end(), -which))
+    ArenaClause clause = m_formula[clauseIdx];
+    if (m_proof)
+    {
+        m_proof->remove(clause);
+    }
+    if (clause.size() == 2)
+    {
+        unwatchBinary(clause[0], clauseIdx);
+        unwatchBinary(clause[1], clauseIdx);
+    }
+    else if (clause.size() > 2)
     {
-        return reason;
+        unwatchLit(clause[0], clauseIdx);
+        unwatchLit(clause[1], clauseIdx);
     }
-    std::set<Literal> literals(reason.begin(), reason.end());
-    literals.insert(b.begin(), b.end());
+    m_formula.free(clauseIdx);
+}
 
-    auto remove2 = std::find(literals.begin(), literals.end(), which);
-    if (literals.end() == remove2)
+void Solver::proveUnsat()
+{
+    if (m_proof)
     {
-        throw std::runtime_error("Clause b doesnt contain literal which");
+        m_proof->add(Clause());
     }
-    literals.erase(which);
-    literals.erase(-which);
-    return Clause(literals.begin(), literals.end());
 }
 
-bool Solver::learnClause(ClauseIndex conflict)
+void Solver::checkGarbage()
 {
-    if (conflict == -1)
+    if (m_formula.wasted() > m_formula.size() * c_garbageFraction)
     {
-        throw std::runtime_error("Delete this: bug - conflict clause is null");
+        garbageCollect();
     }
-    // Find the cut in the implication graph that led to the conflict
-    auto reasonClause = findResponsibleLiterals(m_formula[conflict]);
+}
 
-    if (reasonClause.empty())
+void Solver::relocateClauses(std::vector<ClauseIndex>& clauses, ClauseArena& to)
+{
+    unsigned j = 0;
+    for (ClauseIndex clauseIdx : clauses)
     {
-        // empty clause => UNSAT
-        return true;
+        // shared clauses are never deleted and stay where they are
+        if (isShared(clauseIdx))
+        {
+            clauses[j++] = clauseIdx;
+        }
+        else if (!m_formula[clauseIdx].deleted())
+        {
+            m_formula.relocate(clauseIdx, to);
+            clauses[j++] = clauseIdx;
+        }
+    }
+    clauses.resize(j);
+}
+
+void Solver::cleanWatches()
+{
+    for (WatchList& watchers : m_watches)
+    {
+        watchers.erase(std::remove_if(watchers.begin(), watchers.end(),
+                [this](const Watcher& w){ return !isShared(w.clause) && m_formula[w.clause].deleted(); }), watchers.end());
     }
-    m_formula.push_back(reasonClause);
+    for (BinaryList& implications : m_binWatches)
+    {
+        implications.erase(std::remove_if(implications.begin(), implications.end(),
+                [this](const BinaryWatcher& b){ return !isShared(b.clause) && m_formula[b.clause].deleted(); }), implications.end());
+    }
+}
 
-    // Non-chronologically backtrack ("back jump")
-    bool successful = m_valuation.backjump(reasonClause);
-    return !successful;
+bool Solver::isLocked(ClauseIndex clauseIdx) const
+{
+    // implied literal of a reason clause is always kept at position 0
+    Literal implied = m_formula[clauseIdx][0];
+    return m_valuation.reason(std::abs(implied)) == clauseIdx && m_valuation.isLiteralTrue(implied);
 }
 
-// BUG: ako imamo na ulazu klauze sa duplikat literalima, ne sljaka algoritam, treba da se to obradi na ulazu
-Solver::Solver(std::istream &dimacsStream)
+void Solver::bumpClauseActivity(ArenaClause clause)
 {
-    // skip comments and empty lines
-    std::string line;
-    std::size_t firstNonSpaceIdx;
-    while (std::getline(dimacsStream, line))
+    clause.setActivity(clause.activity() + m_clauseIncrement);
+    if (clause.activity() > c_clauseRescaleLimit)
     {
-        firstNonSpaceIdx = line.find_first_not_of(" \t\r\n");
-        if (firstNonSpaceIdx != std::string::npos && line[firstNonSpaceIdx] != 'c')
+        for (ClauseIndex clauseIdx : m_learned)
         {
-            break;
+            ArenaClause learned = m_formula[clauseIdx];
+            learned.setActivity(learned.activity() / c_clauseRescaleLimit);
         }
+        m_clauseIncrement /= c_clauseRescaleLimit;
     }
+}
+
+void Solver::reduceLearned()
+{
+    // worst clauses first: high glue, then low activity
+    std::sort(m_learned.begin(), m_learned.end(), [this](ClauseIndex a, ClauseIndex b){
+        ArenaClause ca = m_formula[a];
+        ArenaClause cb = m_formula[b];
+        if (ca.lbd() != cb.lbd())
+        {
+            return ca.lbd() > cb.lbd();
+        }
+        return ca.activity() < cb.activity();
+    });
 
-    // problem line
-    if (line[firstNonSpaceIdx] != 'p')
+    unsigned toDelete = m_learned.size() / 2;
+    unsigned j = 0;
+    for (unsigned i = 0; i < m_learned.size(); i++)
     {
-        throw std::runtime_error{DimacsWrongFormat};
+        ClauseIndex clauseIdx = m_learned[i];
+        ArenaClause clause = m_formula[clauseIdx];
+        if (clause.deleted())
+        {
+            // already removed by vivification
+            continue;
+        }
+        if (i < toDelete && clause.size() > 2 && clause.lbd() > c_glueLbd && !isLocked(clauseIdx))
+        {
+            if (m_proof)
+            {
+                m_proof->remove(clause);
+            }
+            m_formula.free(clauseIdx);
+            m_deletedClauses++;
+        }
+        else
+        {
+            m_learned[j++] = clauseIdx;
+        }
     }
-    std::istringstream parser{line.substr(firstNonSpaceIdx+1, std::string::npos)};
-    std::string tmp;
-    if (!(parser >> tmp) || tmp != "cnf")
+    m_learned.resize(j);
+
+    cleanWatches();
+    checkGarbage();
+
+    m_reduceInterval += c_reduceIncrement;
+    m_nextReduce = m_conflicts + m_reduceInterval;
+}
+
+void Solver::garbageCollect()
+{
+    ClauseArena to;
+    to.reserve(m_formula.size() - m_formula.wasted());
+
+    // live clauses first, so that they keep their relative order in memory
+    relocateClauses(m_clauses, to);
+    relocateClauses(m_learned, to);
+
+    for (WatchList& watchers : m_watches)
     {
-        throw std::runtime_error{DimacsWrongFormat};
+        for (Watcher& w : watchers)
+        {
+            if (!isShared(w.clause))
+            {
+                m_formula.relocate(w.clause, to);
+            }
+        }
     }
-    unsigned varCnt, claCnt;
-    if (!(parser >> varCnt >> claCnt))
+    for (BinaryList& implications : m_binWatches)
     {
-        throw std::runtime_error{DimacsWrongFormat};
+        for (BinaryWatcher& b : implications)
+        {
+            if (!isShared(b.clause))
+            {
+                m_formula.relocate(b.clause, to);
+            }
+        }
     }
 
-    // read clauses whilst ignoring comments and empty lines
-    m_valuation.reset(varCnt);
-    m_formula.reserve(claCnt+1000);
-    m_formula.resize(claCnt);
-    ClauseIndex clauseIdx = 0;
-    while (std::getline(dimacsStream, line))
+    for (Literal lit : m_valuation.stack())
     {
-        firstNonSpaceIdx = line.find_first_not_of(" \t\r\n");
-        if (firstNonSpaceIdx != std::string::npos && line[firstNonSpaceIdx] != 'c')
+        ClauseIndex reason = m_valuation.reason(std::abs(lit));
+        if (reason != NullClause && !isShared(reason))
         {
-            parser.clear();
-            parser.str(line);
-            std::copy(std::istream_iterator<int>{parser}, {}, std::back_inserter(m_formula[clauseIdx]));
-            // remove trailing 0
-            m_formula[clauseIdx++].pop_back();
-            watchTwoLiterals(clauseIdx-1);
+            m_formula.relocate(reason, to);
+            m_valuation.setReason(std::abs(lit), reason);
         }
     }
+
+    m_formula.swap(to);
 }
 
 void Solver::watchTwoLiterals(ClauseIndex clauseIdx)
 {
-    if (m_formula[clauseIdx].size() == 0)
+    ArenaClause watched = clause(clauseIdx);
+    if (watched.size() == 0)
     {
         throw std::runtime_error("clause has 0 elements");
     }
-    if (m_formula[clauseIdx].size() == 1)
+    if (watched.size() == 1)
+    {
+        // assigned on level 0 and propagated in the begining, no need to watch this clause
+        Literal unit = watched[0];
+        if (m_valuation.isLiteralUndefined(unit))
+        {
+            m_valuation.push(unit, clauseIdx);
+        }
+        else if (!m_valuation.isLiteralTrue(unit))
+        {
+            // contradicts an earlier unit clause
+            m_ok = false;
+        }
+    }
+    else if (watched.size() == 2)
     {
-        // add to unitClauses which will be propagated in the begining
-        // no need to watch this clause
-        unitClauses.push(clauseIdx);
-        unitLiterals.push(m_formula[clauseIdx][0]);
+        // binary clauses are kept as implications, their memory is only read by conflict analysis
+        Literal lit1 = watched[0];
+        Literal lit2 = watched[1];
+        m_binWatches[litIndex(lit1)].push_back({lit2, clauseIdx});
+        m_binWatches[litIndex(lit2)].push_back({lit1, clauseIdx});
     }
     else
     {
-        Literal watch1 = m_formula[clauseIdx][0];
-        watchLit(watch1, clauseIdx);
-        Literal watch2 = m_formula[clauseIdx][1];
-        watchLit(watch2, clauseIdx);
+        Literal watch1 = watched[0];
+        Literal watch2 = watched[1];
+        if (isShared(clauseIdx))
+        {
+            m_sharedWatches[SharedClauses::watchSlot(clauseIdx)] = watch1 ^ watch2;
+        }
+        watchLit(watch1, clauseIdx, watch2);
+        watchLit(watch2, clauseIdx, watch1);
     }
 }
 
-void Solver::watchLit(Literal lit, ClauseIndex clauseIdx)
+void Solver::watchLit(Literal lit, ClauseIndex clauseIdx, Literal blocker)
+{
+    m_watches[litIndex(lit)].push_back({clauseIdx, blocker});
+}
+
+void Solver::unwatchBinary(Literal lit, ClauseIndex clauseIdx)
 {
-    if (lit < 0)
+    BinaryList& implications = m_binWatches[litIndex(lit)];
+
+    auto it = std::find_if(implications.begin(), implications.end(),
+            [clauseIdx](const BinaryWatcher& b){ return b.clause == clauseIdx; });
+    if (it != implications.end())
     {
-        m_valuation.values()[std::abs(lit)].negWatched.push_back(clauseIdx);
+        *it = implications.back();
+        implications.pop_back();
     }
-    else
+}
+
+void Solver::unwatchLit(Literal lit, ClauseIndex clauseIdx)
+{
+    WatchList& watchedClauses = m_watches[litIndex(lit)];
+
+    auto it = std::find_if(watchedClauses.begin(), watchedClauses.end(),
+            [clauseIdx](const Watcher& w){ return w.clause == clauseIdx; });
+    if (it != watchedClauses.end())
     {
-        m_valuation.values()[std::abs(lit)].posWatched.push_back(clauseIdx);
+        *it = watchedClauses.back();
+        watchedClauses.pop_back();
     }
 }
 
 OptionalPartialValuation Solver::solve2()
 {
-    ClauseIndex conflict = -1;
+    ClauseIndex conflict = NullClause;
     Literal l;
 
-    while(true)
+    m_status = SolveResult::Unsat;
+    m_failedAssumptions.clear();
+    startBudget();
+    if (!m_ok)
     {
-        if (conflict != -1)
+        proveUnsat();
+        return {};
+    }
+    // the previous call may have left a model or a conflict on the stack
+    backjump(0);
+    if (UsePreprocessing && !m_preprocessed)
+    {
+        preprocess();
+        if (!m_ok)
         {
-            clearUnitProps();
+            proveUnsat();
+            return {};
+        }
+    }
+    m_valuation.setUseTargetPhase(UseTargetPhase);
 
-            m_valuation.updateWeights(m_formula[conflict]);
+    while(true)
+    {
+        if (conflict != NullClause)
+        {
             bool isUnsat = learnClause(conflict);
             if (isUnsat)
             {
+                m_ok = false;
+                proveUnsat();
                 return {};
             }
+            m_valuation.updateWeights();
             watchLearnedClause();
 
-            // push learned clause to propagation
-            pushUnitProp(m_valuation.isClauseUnit(m_formula.back()), m_formula.size()-1);
+            // learned clause is unit after the backjump, its UIP is implied right away
+            ClauseIndex learned = m_learned.back();
+            m_valuation.push(m_formula[learned][0], learned);
+
+            conflict = NullClause;
 
-            conflict = -1;
+            if (m_progressOut && m_conflicts >= m_nextProgress)
+            {
+                printProgress();
+            }
+            if (outOfBudget())
+            {
+                m_status = SolveResult::Unknown;
+                return {};
+            }
+        }
+        // if there are assigned literals which weren't propagated, propagate them
+        else if (m_propagated < m_valuation.stackSize())
+        {
+            conflict = propagate();
+        }
+        else if (m_restartPolicy->shouldRestart())
+        {
+            restart();
+            if (!m_ok)
+            {
+                proveUnsat();
+                return {};
+            }
         }
-        // if there is unit prop literal, propagate it
-        else if (!unitLiterals.empty())
+        else if (m_conflicts >= m_nextReduce)
         {
-            conflict = unitProp();
+            reduceLearned();
+        }
+        else if (UseInprocessing && m_conflicts >= m_nextInprocess)
+        {
+            inprocess();
+            if (!m_ok)
+            {
+                proveUnsat();
+                return {};
+            }
+        }
+        else if (UseRephasing && m_conflicts >= m_nextRephase)
+        {
+            rephase();
+        }
+        // everything is propagated, the solver can stop in a state the next call starts from
+        else if (outOfBudget())
+        {
+            m_status = SolveResult::Unknown;
+            return {};
+        }
+        // assumptions are decided first, the level of each one is its index + 1
+        else if (m_valuation.currentLevel() < m_assumptions.size())
+        {
+            Literal assumption = m_assumptions[m_valuation.currentLevel()];
+            if (m_valuation.isLiteralTrue(assumption))
+            {
+                m_valuation.newLevel();
+            }
+            else if (m_valuation.isLiteralUndefined(assumption))
+            {
+                m_valuation.push(assumption, true);
+                m_decisions++;
+            }
+            else
+            {
+                // UNSAT under the assumptions, but the solver stays usable
+                analyzeFinal(assumption);
+                return {};
+            }
         }
-        // if there is an undefined literal, propagate it
+        // if there is an undefined literal, decide it and propagate it in the next step
         else if ((l = m_valuation.decideHeuristic()))
         {
-            pushUnitProp(l, -1);
-            conflict = unitProp();
+            // everything is propagated, so clause indices may move
+            checkGarbage();
+
+            m_valuation.push(l, true);
+            m_decisions++;
         }
         // if no literal was decided, then it's a full valuation - SAT
         else
         {
-            return m_valuation;
+            // eliminated variables get values which satisfy their removed clauses
+            PartialValuation model = m_valuation;
+            Preprocessor::extendModel(m_eliminationStack, model);
+            m_status = SolveResult::Sat;
+            return model;
         }
     }
 }
 
-void Solver::clearUnitProps()
-{
-    while(!unitClauses.empty())
-    {
-        unitClauses.pop();
-        unitLiterals.pop();
-    }
-}
-
-void Solver::pushUnitProp(Literal lit, ClauseIndex ci)
-{
-    unitLiterals.push(lit);
-    unitClauses.push(ci);
-}
-
 // watch-ujemo literale samo ako klauza ima bar 2 literala
 // ako ima samo 1 literal, onda ce biti ubacena na pocetnom levelu, tako da je korektnost zagarantovana
 void Solver::watchLearnedClause()
 {
-    Clause& learnedClause = m_formula.back();
-
-    if (learnedClause.size() < 2)
+    // analyze already put the UIP and the literal from the backjump level in front
+    if (m_formula[m_learned.back()].size() < 2)
     {
         return;
     }
 
-    Literal toBePushed = m_valuation.isClauseUnit(m_formula.back());
-    auto litPos = std::find(learnedClause.begin(), learnedClause.end(), toBePushed);
-    std::swap(*litPos, learnedClause[0]);
-
-    auto lit2Pos = std::max_element(learnedClause.begin(), learnedClause.end(),
-             [&](Literal& l1, Literal& l2){
-        return m_valuation.values()[std::abs(l1)].level < m_valuation.values()[std::abs(l2)].level;
-    });
-    std::swap(*lit2Pos, learnedClause[1]);
-
-    watchTwoLiterals(m_formula.size()-1);
+    watchTwoLiterals(m_learned.back());
 }
 
-ClauseIndex Solver::unitProp()
+ClauseIndex Solver::propagate()
 {
-    Literal lit = unitLiterals.front();
-    if (!m_valuation.isLiteralUndefined(lit))
+    // the stack itself is the propagation queue, literals from m_propagated on are still to be done
+    while (m_propagated < m_valuation.stackSize())
     {
-        if (m_valuation.values()[std::abs(lit)].value != (lit>0?Tribool::True : Tribool::False))
+        Literal lit = m_valuation.stack()[m_propagated++];
+        m_propStats.propagations++;
+
+        // clauses containing the negation of lit, which has just become false
+        ClauseIndex conflict;
+        if ((conflict = updateBinaryClauses(m_binWatches[litIndex(-lit)])) != NullClause)
         {
-            // BUGPOSSIBLE: za unit propove proverava dal dolazi do konflikta
-            // FIXME: trebalo bi da sljaka, ali nisam 100% siguran da je lepo obradjeno
-            //           treba da se odradi: kada se nauci jedinicna klauza
-            //           koja je protivrecna sa prethodno ubacenom jedinicnom klauzom
-            return unitClauses.front();
+            return conflict;
         }
 
-        unitLiterals.pop();
-        unitClauses.pop();
-        return -1;
-    }
-    std::vector<ClauseIndex> &watchedClauses = lit > 0 ?
-            m_valuation.values()[std::abs(lit)].negWatched
-            : m_valuation.values()[std::abs(lit)].posWatched;
-
-    ClauseIndex conflict;
-    if ((conflict = updateWatchedClauses(watchedClauses, lit)) != -1)
-    {
-        return conflict;
+        WatchList &watchedClauses = m_watches[litIndex(-lit)];
+        if ((conflict = updateWatchedClauses(watchedClauses, lit)) != NullClause)
+        {
+            return conflict;
+        }
     }
+    return NullClause;
+}
 
-    if (unitClauses.front() != -1)
-        // if explain clause exists it's a unitProp
-        m_valuation.push(unitLiterals.front(), unitClauses.front());
-    else
-        // else it's a decideProp
-        m_valuation.push(unitLiterals.front(), true);
-    unitLiterals.pop();
-    unitClauses.pop();
+void Solver::backjump(unsigned level, bool savePhases)
+{
+    m_valuation.backjumpToLevel(level, savePhases);
+    // everything below the conflict level was propagated before the next decision
+    m_propagated = std::min<std::size_t>(m_propagated, m_valuation.stackSize());
+}
 
-    return -1;
+void Solver::changeWatchedLiteral(WatchList &watchedClauses,
+            unsigned currClauseInd, int currLitInd, int otherLitInd)
+{
+    Watcher w = watchedClauses[currClauseInd];
+    ArenaClause currClause = m_formula[w.clause];
+    std::swap(currClause[currLitInd], currClause[otherLitInd]);
+    // the literal that stays watched is the best blocker we know of
+    w.blocker = currClause[1 - currLitInd];
+    m_watches[litIndex(currClause[currLitInd])].push_back(w);
+    watchedClauses[currClauseInd] = watchedClauses[watchedClauses.size()-1];
+    watchedClauses.pop_back();
 }
 
-void Solver::changeWatchedLiteral(std::vector<ClauseIndex> &watchedClauses,
-            ClauseIndex currClauseInd, int currLitInd, int otherLitInd)
+ClauseIndex Solver::updateBinaryClauses(const BinaryList &implications)
 {
-    auto& currClause = m_formula[watchedClauses[currClauseInd]];
-    if (currClause[otherLitInd] > 0)
-    {
-        m_valuation.values()[std::abs(currClause[otherLitInd])].posWatched.push_back(watchedClauses[currClauseInd]);
-    }
-    else
+    for (const BinaryWatcher &b : implications)
     {
-        m_valuation.values()[std::abs(currClause[otherLitInd])].negWatched.push_back(watchedClauses[currClauseInd]);
+        m_propStats.binaryVisits++;
+        if (m_valuation.isLiteralTrue(b.implied))
+        {
+            continue;
+        }
+
+        if (m_valuation.isLiteralUndefined(b.implied))
+        {
+            m_valuation.push(b.implied, b.clause);
+        }
+        else
+        {
+            // CONFLICT
+            return b.clause;
+        }
     }
-    watchedClauses[currClauseInd] = watchedClauses[watchedClauses.size()-1];
-    watchedClauses.pop_back();
-    std::swap(currClause[currLitInd], currClause[otherLitInd]);
+    return NullClause;
 }
 
-ClauseIndex Solver::updateWatchedClauses(std::vector<ClauseIndex> &watchedClauses, Literal lit)
+ClauseIndex Solver::updateWatchedClauses(WatchList &watchedClauses, Literal lit)
 {
     unsigned i = 0;
     int nonFalseLitInd;
+    Literal falseLit = -lit;
     while (i < watchedClauses.size())
     {
-        Clause &currClause = m_formula[watchedClauses[i]];
-        if (std::abs(lit) == std::abs(currClause[1]))
+        Watcher &w = watchedClauses[i];
+        m_propStats.watcherVisits++;
+
+        // satisfied clause, no need to touch its memory
+        if (m_valuation.isLiteralTrue(w.blocker))
         {
-            std::swap(currClause[0], currClause[1]);
+            m_propStats.blockerSkips++;
+            i++;
+            continue;
+        }
+
+        if (isShared(w.clause))
+        {
+            ClauseIndex clauseIdx = w.clause;
+            if (!updateSharedClause(watchedClauses, i, falseLit))
+            {
+                // CONFLICT
+                return clauseIdx;
+            }
+            continue;
         }
-        Literal watch2 = currClause[1];
+
+        ArenaClause currClause = m_formula[w.clause];
+        m_propStats.clauseVisits++;
+        Literal watch2 = currClause[0] == falseLit ? currClause[1] : currClause[0];
 
         if (m_valuation.isLiteralTrue(watch2))
         {
+            w.blocker = watch2;
             i++;
+            continue;
+        }
+
+        // false literal goes to position 1, the other watched one to 0
+        if (currClause[0] == falseLit)
+        {
+            std::swap(currClause[0], currClause[1]);
         }
-        else if ((nonFalseLitInd = m_valuation.posOfFirstNonFalseInClause(currClause, 2)) != -1)
+
+        if ((nonFalseLitInd = m_valuation.posOfFirstNonFalseInClause(currClause, 2)) != -1)
         {
-            changeWatchedLiteral(watchedClauses, i, 0, nonFalseLitInd);
+            changeWatchedLiteral(watchedClauses, i, 1, nonFalseLitInd);
         }
         else if (m_valuation.isLiteralUndefined(watch2))
         {
             // UnitProp that other watched lit
-            pushUnitProp(watch2, watchedClauses[i]);
+            m_valuation.push(watch2, w.clause);
             i++;
         }
         else
         {
             // CONFLICT
-            m_valuation.push(unitLiterals.front(), unitClauses.front());
-            return watchedClauses[i];
+            return w.clause;
+        }
+    }
+    return NullClause;
+}
+
+bool Solver::updateSharedClause(WatchList &watchedClauses, unsigned &currClauseInd, Literal falseLit)
+{
+    Watcher &w = watchedClauses[currClauseInd];
+    Literal &watched = m_sharedWatches[SharedClauses::watchSlot(w.clause)];
+    Literal watch2 = watched ^ falseLit;
+    m_propStats.clauseVisits++;
+
+    if (m_valuation.isLiteralTrue(watch2))
+    {
+        w.blocker = watch2;
+        currClauseInd++;
+        return true;
+    }
+
+    // literals stay in place, so the whole clause is searched, except for the other watched one
+    ArenaClause currClause = (*m_shared)[w.clause];
+    for (Literal lit : currClause)
+    {
+        if (lit != watch2 && !m_valuation.isLiteralFalse(lit))
+        {
+            watched = lit ^ watch2;
+            m_watches[litIndex(lit)].push_back({w.clause, watch2});
+            w = watchedClauses.back();
+            watchedClauses.pop_back();
+            return true;
         }
     }
-    return -1;
+    if (m_valuation.isLiteralUndefined(watch2))
+    {
+        // UnitProp that other watched lit
+        m_valuation.push(watch2, w.clause);
+        currClauseInd++;
+        return true;
+    }
+    return false;
 }
 
 OptionalPartialValuation Solver::solve()
 {
+    m_status = SolveResult::Unsat;
     while (true)
     {
         Literal l;
         ClauseIndex conflict;
         ClauseIndex unitClause;
-        if ( (conflict = hasConflict()) != -1 )
+        if ( (conflict = hasConflict()) != NullClause )
         {
             if (UseLearning)
             {
-                m_valuation.updateWeights(m_formula[conflict]);
                 bool isUnsat = learnClause(conflict);
                 if (isUnsat)
                 {
                     return {};
                 }
+                m_valuation.updateWeights();
             }
             else
             {
+                m_conflicts++;
                 Literal decidedLiteral = m_valuation.backjump();
                 if (NullLiteral == decidedLiteral)
                 {
@@ -361,14 +1706,15 @@ OptionalPartialValuation Solver::solve()
                 m_valuation.push(-decidedLiteral, false);
             }
         }
-        else if ( (unitClause = hasUnitClause(l)) != -1 )
+        else if ( (unitClause = hasUnitClause(l)) != NullClause )
         {
             // unit prop with stored unitClause
-            if (m_formula[unitClause].empty())
+            if (clause(unitClause).empty())
             {
                 throw std::runtime_error("unit props unit clause has 0 elements.");
             }
             m_valuation.push(l, unitClause);
+            m_propStats.propagations++;
         }
         else
         {
@@ -379,10 +1725,12 @@ OptionalPartialValuation Solver::solve()
             if (l)
             {
                 m_valuation.push(l, true);
+                m_decisions++;
             }
             else
             {
                 // if no literal was decided, then it's a full valuation - SAT
+                m_status = SolveResult::Sat;
                 return m_valuation;
             }
         }
@@ -391,54 +1739,186 @@ OptionalPartialValuation Solver::solve()
 
 std::string Solver::getInfo() const
 {
-    return "stack size = " + std::to_string(m_valuation.stackSize()) +
-            "\ndecides = " + std::to_string(m_valuation.decides.size()) +
-//            "\nlearned clauses = " + std::to_string(m_learned.size()) +
-            "\nunit propagations = " + "unknown" +
-            "\nrestarts = " + std::to_string(0);
+    std::string minimizedPercent = "0%";
+    if (m_learnStats.literalsBeforeMinimization)
+    {
+        minimizedPercent = std::to_string(100 * (m_learnStats.literalsBeforeMinimization - m_learnStats.literalsAfterMinimization)
+                                          / m_learnStats.literalsBeforeMinimization) + "%";
+    }
+
+    return "loaded " + std::to_string(m_loadStats.bytes / 1e6) + " MB in " +
+            std::to_string(m_loadStats.seconds * 1000) + " ms (" +
+            std::to_string(m_loadStats.megabytesPerSecond()) + " MB/s)" +
+            "\nduplicate literals removed on load = " + std::to_string(m_loadStats.removedDuplicates) +
+            "\ntautologies removed on load = " + std::to_string(m_loadStats.removedTautologies) +
+            "\npreprocessing: eliminated variables = " + std::to_string(m_preprocessStats.eliminatedVars) +
+            ", eliminated clauses = " + std::to_string(m_preprocessStats.eliminatedClauses) +
+            ", resolvents = " + std::to_string(m_preprocessStats.resolvents) +
+            ", subsumed clauses = " + std::to_string(m_preprocessStats.subsumedClauses) +
+            ", strengthened literals = " + std::to_string(m_preprocessStats.strengthenedLiterals) +
+            ", time = " + std::to_string(m_preprocessStats.seconds * 1000) + " ms" +
+            (m_preprocessStats.timedOut ? " (timed out)" : "") +
+            "\ninprocessing rounds = " + std::to_string(m_inprocessStats.rounds) +
+            "\nprobing: probes = " + std::to_string(m_inprocessStats.probes) +
+            ", failed literals = " + std::to_string(m_inprocessStats.failedLiterals) +
+            ", time = " + std::to_string(m_inprocessStats.probeSeconds * 1000) + " ms" +
+            "\nvivification: clauses = " + std::to_string(m_inprocessStats.vivifiedClauses) +
+            ", shortened = " + std::to_string(m_inprocessStats.shortenedClauses) +
+            ", removed literals = " + std::to_string(m_inprocessStats.removedLiterals) +
+            ", time = " + std::to_string(m_inprocessStats.vivifySeconds * 1000) + " ms" +
+            "\nexported clauses = " + std::to_string(m_exportedClauses) +
+            "\nimported clauses = " + std::to_string(m_importedClauses) +
+            "\nstack size = " + std::to_string(m_valuation.stackSize()) +
+            "\ndecides = " + std::to_string(m_decisions) +
+            "\nlearned clauses = " + std::to_string(m_learned.size()) +
+            "\ndeleted learned clauses = " + std::to_string(m_deletedClauses) +
+            "\nunit propagations = " + std::to_string(m_propStats.propagations) +
+            "\nconflicts = " + std::to_string(m_conflicts) +
+            "\nlearned literals = " + std::to_string(m_learnStats.literalsAfterMinimization) +
+            "\nlearned literals removed by minimization = " + minimizedPercent +
+            "\nbinary implications visited = " + std::to_string(m_propStats.binaryVisits) +
+            "\nwatcher visits = " + std::to_string(m_propStats.watcherVisits) +
+            "\nclause visits = " + std::to_string(m_propStats.clauseVisits) +
+            "\nclause visits avoided by blockers = " + std::to_string(m_propStats.blockerSkips) +
+            "\nrestarts = " + std::to_string(m_restarts) +
+            "\nrephases = " + std::to_string(m_rephases) +
+            "\npeak memory = " + std::to_string(peakMemoryMegabytes()) + " MB";
+}
+
+SolverStats Solver::stats() const
+{
+    SolverStats stats;
+    stats.decisions = m_decisions;
+    stats.propagations = m_propStats.propagations;
+    stats.conflicts = m_conflicts;
+    stats.learnedClauses = m_learnStats.clauses;
+    stats.learnedLiterals = m_learnStats.literalsAfterMinimization;
+    stats.restarts = m_restarts;
+    stats.deletedClauses = m_deletedClauses;
+    stats.fixedVariables = m_valuation.rootSize();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_created).count();
+    stats.peakMemoryMB = peakMemoryMegabytes();
+    return stats;
+}
+
+void Solver::printProgress()
+{
+    SolverStats current = stats();
+    *m_progressOut << "c progress: conflicts = " << current.conflicts
+                   << ", decisions = " << current.decisions
+                   << ", propagations = " << current.propagations
+                   << ", restarts = " << current.restarts
+                   << ", learned = " << m_learned.size()
+                   << ", fixed = " << current.fixedVariables
+                   << ", time = " << current.seconds << " s"
+                   << ", memory = " << current.peakMemoryMB << " MB" << std::endl;
+    m_nextProgress = m_conflicts + m_progressInterval;
+}
+
+std::string Solver::getJson() const
+{
+    SolverStats current = stats();
+    const char* status = m_status == SolveResult::Sat ? "SAT" : m_status == SolveResult::Unsat ? "UNSAT" : "UNKNOWN";
+
+    std::ostringstream json;
+    json << "{\"status\": \"" << status << "\""
+         << ", \"stopReason\": \"" << stopReasonName(m_stopReason) << "\""
+         << ", \"seconds\": " << current.seconds
+         << ", \"peakMemoryMB\": " << current.peakMemoryMB
+         << ",\n \"search\": {\"decisions\": " << current.decisions
+         << ", \"propagations\": " << current.propagations
+         << ", \"conflicts\": " << current.conflicts
+         << ", \"restarts\": " << current.restarts
+         << ", \"rephases\": " << m_rephases
+         << ", \"fixedVariables\": " << current.fixedVariables << "}"
+         << ",\n \"learning\": {\"learnedClauses\": " << current.learnedClauses
+         << ", \"learnedLiterals\": " << current.learnedLiterals
+         << ", \"literalsBeforeMinimization\": " << m_learnStats.literalsBeforeMinimization
+         << ", \"keptClauses\": " << m_learned.size()
+         << ", \"deletedClauses\": " << current.deletedClauses << "}"
+         << ",\n \"propagation\": {\"binaryVisits\": " << m_propStats.binaryVisits
+         << ", \"watcherVisits\": " << m_propStats.watcherVisits
+         << ", \"clauseVisits\": " << m_propStats.clauseVisits
+         << ", \"blockerSkips\": " << m_propStats.blockerSkips << "}"
+         << ",\n \"load\": {\"bytes\": " << m_loadStats.bytes
+         << ", \"seconds\": " << m_loadStats.seconds
+         << ", \"removedDuplicates\": " << m_loadStats.removedDuplicates
+         << ", \"removedTautologies\": " << m_loadStats.removedTautologies << "}"
+         << ",\n \"preprocessing\": {\"eliminatedVars\": " << m_preprocessStats.eliminatedVars
+         << ", \"eliminatedClauses\": " << m_preprocessStats.eliminatedClauses
+         << ", \"resolvents\": " << m_preprocessStats.resolvents
+         << ", \"subsumedClauses\": " << m_preprocessStats.subsumedClauses
+         << ", \"strengthenedLiterals\": " << m_preprocessStats.strengthenedLiterals
+         << ", \"seconds\": " << m_preprocessStats.seconds
+         << ", \"timedOut\": " << (m_preprocessStats.timedOut ? "true" : "false") << "}"
+         << ",\n \"inprocessing\": {\"rounds\": " << m_inprocessStats.rounds
+         << ", \"probes\": " << m_inprocessStats.probes
+         << ", \"failedLiterals\": " << m_inprocessStats.failedLiterals
+         << ", \"vivifiedClauses\": " << m_inprocessStats.vivifiedClauses
+         << ", \"shortenedClauses\": " << m_inprocessStats.shortenedClauses
+         << ", \"removedLiterals\": " << m_inprocessStats.removedLiterals << "}"
+         << ",\n \"sharing\": {\"exportedClauses\": " << m_exportedClauses
+         << ", \"importedClauses\": " << m_importedClauses << "}}";
+    return json.str();
 }
 
 ClauseIndex Solver::hasConflict() const
 {
-    for (unsigned i = 0; i < m_formula.size(); ++i)
+    for (const std::vector<ClauseIndex>* clauses : {&m_clauses, &m_learned})
     {
-        if ( m_valuation.isClauseFalse(m_formula[i]))
+        for (ClauseIndex clauseIdx : *clauses)
         {
-            return i;
+            if ( !clause(clauseIdx).deleted() && m_valuation.isClauseFalse(clause(clauseIdx)))
+            {
+                return clauseIdx;
+            }
         }
     }
-    return -1;
+    return NullClause;
 }
 
 ClauseIndex Solver::hasUnitClause(Literal & l) const
 {
-    for (unsigned i = 0; i < m_formula.size(); ++i)
+    for (const std::vector<ClauseIndex>* clauses : {&m_clauses, &m_learned})
     {
-        if (( l = m_valuation.isClauseUnit(m_formula[i]) ))
+        for (ClauseIndex clauseIdx : *clauses)
         {
-            return i;
+            if ( !clause(clauseIdx).deleted() && ( l = m_valuation.isClauseUnit(clause(clauseIdx)) ))
+            {
+                return clauseIdx;
+            }
         }
     }
     l = NullLiteral;
-    return -1;
+    return NullClause;
 }
 
 void Solver::printAllWatchedClauses()
 {
-    for (unsigned i = 1; i < m_valuation.values().size(); ++i)
+    for (unsigned i = 1; i <= m_valuation.varCount(); ++i)
     {
         std::cout << "\n";
-        LiteralInfo &litInf = m_valuation.values()[i];
+        Literal lit = i;
         std::cout << "Lit: " << i << std::endl;
         std::cout << "  Pos Watched:" << std::endl;
-        for (ClauseIndex cl : litInf.posWatched)
+        for (Watcher w : m_watches[litIndex(lit)])
         {
-            std::cout << "    " << m_formula[cl] << std::endl;
+            std::cout << "    " << clause(w.clause) << std::endl;
         }
         std::cout << "  Neg Watched:" << std::endl;
-        for (ClauseIndex cl : litInf.negWatched)
+        for (Watcher w : m_watches[litIndex(-lit)])
+        {
+            std::cout << "    " << clause(w.clause) << std::endl;
+        }
+        std::cout << "  Pos Binary:" << std::endl;
+        for (BinaryWatcher b : m_binWatches[litIndex(lit)])
+        {
+            std::cout << "    " << clause(b.clause) << std::endl;
+        }
+        std::cout << "  Neg Binary:" << std::endl;
+        for (BinaryWatcher b : m_binWatches[litIndex(-lit)])
         {
-            std::cout << "    " << m_formula[cl] << std::endl;
+            std::cout << "    " << clause(b.clause) << std::endl;
         }
     }
     std::cout << "\n\n";
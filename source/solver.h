@@ -2,13 +2,205 @@
 #define SOLVER_H
 
 #include "partial_valuation.h"
+#include "watcher.h"
+#include "restart_policy.h"
+#include "dimacs_parser.h"
+#include "preprocessor.h"
+#include "clause_sharing.h"
+#include "proof_writer.h"
+#include "shared_clauses.h"
 
 #include <iostream>
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 #include <experimental/optional>
 
 using OptionalPartialValuation = std::experimental::optional<PartialValuation>;
 
+/**
+ * @brief The SolveResult enum - answer of a solver, Unknown if it was stopped before it found one
+ */
+enum class SolveResult
+{
+    Sat,
+    Unsat,
+    Unknown
+};
+
+/**
+ * @brief The SolveBudget struct - limits of one call to solve2, after which it gives up
+ * with SolveResult::Unknown; 0 means no limit
+ */
+struct SolveBudget
+{
+    unsigned long long conflicts = 0;
+    unsigned long long propagations = 0;
+    // wall time
+    double seconds = 0;
+    // clause database and watch lists of the solver, not of the whole process
+    double memoryMB = 0;
+};
+
+/**
+ * @brief The StopReason enum - why the last call to solve2 ended
+ */
+enum class StopReason
+{
+    // it found an answer
+    Finished,
+    // interrupt or the terminate flag
+    Interrupted,
+    ConflictBudget,
+    PropagationBudget,
+    TimeBudget,
+    MemoryBudget
+};
+
+const char* stopReasonName(StopReason reason);
+
+class Solver;
+
+/**
+ * @brief The SolveHandle class - a solve running on its own thread, see Solver::solveAsync.
+ *
+ * @details Destroying a handle of an unfinished solve cancels it and waits for it.
+ */
+class SolveHandle
+{
+public:
+    SolveHandle() = default;
+    SolveHandle(SolveHandle&&) = default;
+    SolveHandle& operator=(SolveHandle&& other);
+    ~SolveHandle();
+
+    /**
+     * @brief valid - whether the handle has a solve whose result wasn't taken by get yet
+     */
+    bool valid() const
+    {
+        return m_result.valid();
+    }
+
+    /**
+     * @brief ready - whether the solve has finished, so that get won't block
+     */
+    bool ready() const;
+
+    void wait() const
+    {
+        m_result.wait();
+    }
+
+    /**
+     * @return whether the solve finished within the timeout
+     */
+    template <typename Rep, typename Period>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout) const
+    {
+        return m_result.wait_for(timeout) == std::future_status::ready;
+    }
+
+    /**
+     * @brief cancel - asks the solve to stop, it returns Unknown soon after; doesn't wait for it
+     */
+    void cancel();
+
+    /**
+     * @brief get - waits for the solve and returns its result, the handle isn't valid after it
+     */
+    SolveResult get();
+
+private:
+    friend class Solver;
+
+    SolveHandle(std::shared_ptr<std::atomic<bool>> cancelled, std::future<SolveResult> result)
+        : m_cancelled(std::move(cancelled)), m_result(std::move(result))
+    {
+    }
+
+    // read by the solver only while this solve runs, so a late cancel can't stop the next one
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+    std::future<SolveResult> m_result;
+};
+
+/**
+ * @brief The Lookahead struct - result of Solver::lookahead for a cube
+ */
+struct Lookahead
+{
+    // the cube contradicts the formula
+    bool refuted = false;
+    // variable to split the cube on as a literal, NullLiteral if propagating the cube assigns everything
+    Literal branch = NullLiteral;
+    // variables assigned by propagating the cube
+    unsigned assigned = 0;
+};
+
+/**
+ * @brief The LearningStats struct - counters of the learned clause minimization
+ */
+struct LearningStats
+{
+    unsigned long long clauses = 0;
+    unsigned long long literalsBeforeMinimization = 0;
+    unsigned long long literalsAfterMinimization = 0;
+};
+
+/**
+ * @brief The PropagationStats struct - counters of the two-watched-literals propagation
+ */
+struct PropagationStats
+{
+    // literals taken off the propagation queue
+    unsigned long long propagations = 0;
+    // binary implications looked at in updateBinaryClauses
+    unsigned long long binaryVisits = 0;
+    // watchers looked at in updateWatchedClauses
+    unsigned long long watcherVisits = 0;
+    // watchers whose clause memory had to be read
+    unsigned long long clauseVisits = 0;
+    // watchers skipped because their blocker literal was true
+    unsigned long long blockerSkips = 0;
+};
+
+/**
+ * @brief The SolverStats struct - main counters of the search, they're always on because
+ * each of them costs one increment per decision, propagated literal or conflict
+ */
+struct SolverStats
+{
+    unsigned long long decisions = 0;
+    unsigned long long propagations = 0;
+    unsigned long long conflicts = 0;
+    unsigned long long learnedClauses = 0;
+    unsigned long long learnedLiterals = 0;
+    unsigned long long restarts = 0;
+    unsigned long long deletedClauses = 0;
+    // variables assigned at level 0
+    unsigned long long fixedVariables = 0;
+    // since the solver was created
+    double seconds = 0;
+    double peakMemoryMB = 0;
+};
+
+/**
+ * @brief The InprocessStats struct - counters and times of the inprocessing rounds
+ */
+struct InprocessStats
+{
+    unsigned long long rounds = 0;
+    unsigned long long probes = 0;
+    unsigned long long failedLiterals = 0;
+    // learned clauses which vivification tried to shorten, and how many of them it did
+    unsigned long long vivifiedClauses = 0;
+    unsigned long long shortenedClauses = 0;
+    unsigned long long removedLiterals = 0;
+    double probeSeconds = 0;
+    double vivifySeconds = 0;
+};
+
 class Solver
 {
 public:
@@ -18,18 +210,73 @@ public:
     */
 //    Solver(const CNFFormula &formula);
 
+    /**
+    * @brief Solver - prazan solver, promenljive i klauze se dodaju sa addClause
+    */
+    Solver();
+
     /**
     * @brief Solver - konstruktor od C++ stream-a iz koga se cita CNF u DIMACS formatu
     * @param dimacsStream - ulazni stream
     */
     Solver(std::istream &dimacsStream);
 
+    /**
+    * @brief Solver - konstruktor od formule koju je vec procitao DimacsParser
+    * @param formula - CNF za koji proveravamo zadovoljivost
+    */
+    Solver(const DimacsFormula &formula);
+
+    /**
+     * @brief Solver - works on clauses which other solvers read at the same time, without copying them
+     * @param clauses - must stay alive and unchanged as long as the solver
+     */
+    Solver(const SharedClauses &clauses);
+
     /**
     * @brief solve - DPLL algoritam za proveru zadovoljivosti
     * @return parcijalnu valuaciju ili nista
     */
     OptionalPartialValuation solve();
 
+    /**
+     * @brief addClause - adds a clause to the formula, also between two calls to solve.
+     * Variables which weren't seen before are created.
+     * @return false if the formula became UNSAT
+     */
+    bool addClause(const Clause& clause);
+
+    /**
+     * @brief solve - searches for a model in which all the assumptions are true, with solve2.
+     * Learned clauses, activities and phases are kept for the next call, so a series of
+     * similar queries can be solved by one solver.
+     * @return Unsat if the formula is UNSAT under the assumptions, see failedAssumptions
+     */
+    SolveResult solve(const std::vector<Literal>& assumptions);
+
+    /**
+     * @brief solveAsync - runs solve(assumptions) on a new thread. The solver mustn't be used
+     * or destroyed until the solve has finished, except for interrupt and the handle's cancel.
+     */
+    SolveHandle solveAsync(const std::vector<Literal>& assumptions = {});
+
+    /**
+     * @brief failedAssumptions - after an Unsat answer, assumptions which are UNSAT together
+     * with the formula; empty if the formula is UNSAT without any
+     */
+    const std::vector<Literal>& failedAssumptions() const
+    {
+        return m_failedAssumptions;
+    }
+
+    /**
+     * @brief model - after a Sat answer of solve(assumptions), the found model
+     */
+    const OptionalPartialValuation& model() const
+    {
+        return m_model;
+    }
+
     /**
     * @brief solve2 - DPLL algoritam za proveru zadovoljivosti sa 2-nadgledana literala
     * @return parcijalnu valuaciju ili nista
@@ -41,19 +288,164 @@ public:
      */
     bool UseLearning;
 
+    /**
+     * @brief UseTargetPhase whether decisions should follow the phases of the longest
+     * conflict-free assignment since the last restart
+     */
+    bool UseTargetPhase = true;
+
+    /**
+     * @brief UseRephasing whether saved phases should be periodically reset to the best,
+     * inverted or original ones
+     */
+    bool UseRephasing = true;
+
+    /**
+     * @brief UsePreprocessing whether solve2 should simplify the formula with subsumption,
+     * strengthening and variable elimination before the search
+     */
+    bool UsePreprocessing = true;
+
+    /**
+     * @brief UseInprocessing whether solve2 should periodically probe failed literals and
+     * vivify learned clauses at the root level
+     */
+    bool UseInprocessing = true;
+
+    /**
+     * @brief setRestartStrategy - selects the restart policy used by solve2, Luby by default
+     */
+    void setRestartStrategy(RestartStrategy strategy);
+
+    /**
+     * @brief setSeed - randomizes the initial order of decisions, so that solvers with
+     * different seeds search different parts of the space first
+     */
+    void setSeed(unsigned seed);
+
+    /**
+     * @brief setInitialPhase - value which variables get when they're decided for the first time
+     */
+    void setInitialPhase(bool positive);
+
+    /**
+     * @brief setClauseSharing - solve2 will export short and low-LBD learned clauses to sharing
+     * and import clauses from it on every restart, nullptr turns sharing off
+     */
+    void setClauseSharing(ClauseSharing* sharing)
+    {
+        m_sharing = sharing;
+    }
+
+    /**
+     * @brief setProofWriter - solve2 logs every clause it learns, derives by preprocessing or
+     * inprocessing and deletes to proof, and the empty clause when it finds the formula UNSAT,
+     * nullptr turns logging off. It has to be set before the first solve2 and the proof is
+     * checked against the formula the solver was created with; clauses imported by clause
+     * sharing and clauses added with addClause aren't part of it.
+     */
+    void setProofWriter(ProofWriter* proof)
+    {
+        m_proof = proof;
+    }
+
+    /**
+     * @brief setTerminateFlag - solve2 checks the flag after every conflict and decision and
+     * gives up with SolveResult::Unknown once it's set, the flag is shared by several solvers
+     */
+    void setTerminateFlag(const std::atomic<bool>* terminate)
+    {
+        m_terminate = terminate;
+    }
+
+    /**
+     * @brief interrupt - makes the running solve2, or the next one if none is running, give up
+     * with SolveResult::Unknown; can be called from any thread. The request is used up by
+     * the solve it stops, so the following one runs normally.
+     */
+    void interrupt()
+    {
+        m_interrupt.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief setBudget - limits of every following call to solve2, counted from its start.
+     * Preprocessing and inprocessing rounds aren't interrupted, a budget is checked after
+     * every conflict and decision, the time and memory ones less often.
+     */
+    void setBudget(const SolveBudget& budget)
+    {
+        m_budget = budget;
+    }
+
+    const SolveBudget& budget() const
+    {
+        return m_budget;
+    }
+
+    /**
+     * @brief setConflictLimit - the conflict budget, 0 means no limit
+     */
+    void setConflictLimit(unsigned long long limit)
+    {
+        m_budget.conflicts = limit;
+    }
+
+    /**
+     * @brief stopReason - why the last call to solve2 ended, anything but Finished means Unknown
+     */
+    StopReason stopReason() const
+    {
+        return m_stopReason;
+    }
+
+    /**
+     * @brief memoryMegabytes - size of the clause database and watch lists, as limited by the memory budget
+     */
+    double memoryMegabytes() const;
+
+    /**
+     * @brief lookahead - propagates the cube and picks the variable which splits it best:
+     * the one whose two values propagate the most, measured by the product of both counts
+     * (as in march). The solver is left at level 0.
+     */
+    Lookahead lookahead(const std::vector<Literal>& cube);
+
+    unsigned long long conflicts() const
+    {
+        return m_conflicts;
+    }
+
+    /**
+     * @brief status - result of the last call to solve2
+     */
+    SolveResult status() const
+    {
+        return m_status;
+    }
+
     std::string getInfo() const;
-private:
+
+    SolverStats stats() const;
 
     /**
-     * @brief resolution - resolves clause a with b
-     * @param reason - current explain clause
-     * @param b - top clause on the stack
-     * @param which - literal on which to resolve
-     * @return resolved a and b, if b couldn't resolve variable from a, then returns a
+     * @brief getJson - all statistics as one JSON object, for scripts which compare runs
      */
-    Clause resolution(Clause& reason, Clause& b, Literal& which) const;
+    std::string getJson() const;
 
-    const std::string DimacsWrongFormat = "Wrong input format of DIMACS stream";
+    /**
+     * @brief setProgressOutput - solve2 prints a line with the main counters to out every
+     * interval conflicts, nullptr turns it off
+     */
+    void setProgressOutput(std::ostream* out, unsigned long long interval = c_defaultProgressInterval)
+    {
+        m_progressOut = out;
+        m_progressInterval = interval;
+        m_nextProgress = m_conflicts + interval;
+    }
+
+    static const unsigned long long c_defaultProgressInterval = 10000;
+private:
 
     /**
      * @brief checks if there is a conflict with the current valuation
@@ -76,40 +468,416 @@ private:
     bool learnClause(ClauseIndex conflict);
 
     /**
-     * @brief newClauseFromConflicting - constructs a learned clause from a conflicting one
-     * @param conflict - clause that led to conflict
-     * @return returns a learned clause that should be added to the formula
+     * @brief analyze - first UIP conflict analysis, walks the stack once from the top
+     * @param conflict - clause which is false in the current valuation
+     * @param learned - receives the asserting clause, negation of the UIP first and
+     * a literal from the backjump level second
+     * @param backjumpLevel - receives the level to which to backjump
+     */
+    void analyze(ClauseIndex conflict, Clause& learned, unsigned& backjumpLevel);
+
+    /**
+     * @brief minimize - removes literals of the learned clause which are implied by the others
+     * @details Called by analyze while seen flags of the learned literals are still set.
+     * @param learned - clause from analyze, first literal is never removed
+     */
+    void minimize(Clause& learned);
+
+    /**
+     * @brief isRedundant - checks recursively if the reason of lit consists only of literals
+     * which are in the learned clause or are redundant themselves
+     * @param levels - abstraction of the levels in the learned clause
+     */
+    bool isRedundant(Literal lit, uint32_t levels);
+
+    /**
+     * @brief computeLbd - number of distinct decision levels among literals of the clause
+     */
+    unsigned computeLbd(const Clause& clause);
+
+    /**
+     * @brief restart - backtracks to level 0, keeping learned clauses and weights
+     */
+    void restart();
+
+    /**
+     * @brief startBudget - turns the budget into limits of the solve2 which is starting
+     */
+    void startBudget();
+
+    /**
+     * @brief outOfBudget - whether solve2 has to give up, sets m_stopReason if it does
+     */
+    bool outOfBudget();
+
+    /**
+     * @brief rephase - resets saved phases, the kind of reset cycles through a fixed schedule
+     */
+    void rephase();
+
+    /**
+     * @brief preprocess - simplifies the original clauses with the Preprocessor and loads
+     * the result instead of them, called before the first search
+     */
+    void preprocess();
+
+    /**
+     * @brief growVariables - makes room for variables up to nVars
+     */
+    void growVariables(unsigned nVars);
+
+    /**
+     * @brief addInputClause - simplifies the clause by the root level values and adds it,
+     * called at level 0
+     */
+    bool addInputClause(Clause clause);
+
+    /**
+     * @brief restoreEliminated - takes the clauses of an eliminated variable off the elimination
+     * stack and adds them back, so the variable can be used in new clauses or assumptions
+     */
+    void restoreEliminated(unsigned var);
+
+    /**
+     * @brief analyzeFinal - collects assumptions which imply the negation of the given one
+     * into m_failedAssumptions
      */
-    Clause negateClauseLiterals(Clause& conflict) const;
+    void analyzeFinal(Literal assumption);
 
-    Clause findResponsibleLiterals(Clause& conflict);
+    void printProgress();
 
-    ClauseIndex unitProp();
+    /**
+     * @brief importClauses - adds clauses exported by other solvers, called at level 0
+     */
+    void importClauses();
+
+    /**
+     * @brief inprocess - one round of failed literal probing and vivification, at level 0
+     */
+    void inprocess();
 
-    void clearUnitProps();
+    /**
+     * @brief probe - assigns roots of the binary implication graph one at a time, a literal
+     * whose propagation ends in a conflict is failed and its negation is learned as a unit
+     */
+    void probe();
 
-    void pushUnitProp(Literal lit, ClauseIndex ci);
+    /**
+     * @brief vivify - tries to shorten the best learned clauses with vivifyClause
+     */
+    void vivify();
+
+    /**
+     * @brief vivifyClause - assigns negations of the clause's literals one by one and propagates;
+     * a literal which becomes false is redundant, and a conflict or a true literal means the
+     * literals assigned so far already make a clause
+     * @return false if the formula is found to be UNSAT
+     */
+    bool vivifyClause(ClauseIndex clauseIdx);
+
+    /**
+     * @brief learnUnit - adds lit as a learned unit clause at level 0 and propagates it
+     * @return false if the formula is found to be UNSAT
+     */
+    bool learnUnit(Literal lit);
+
+    /**
+     * @brief abstractLevel - one bit out of 32 for the level of the variable
+     */
+    uint32_t abstractLevel(unsigned var) const
+    {
+        return 1u << (m_valuation.level(var) & 31);
+    }
+
+    /**
+     * @brief propagate - unit propagation of all assigned literals which weren't propagated yet
+     * @return conflicting clause, NullClause if there is none
+     */
+    ClauseIndex propagate();
+
+    /**
+     * @brief backjump - backjumps the valuation to the given level and the propagation with it
+     */
+    void backjump(unsigned level, bool savePhases = true);
 
     void watchLearnedClause();
 
     void watchTwoLiterals(ClauseIndex clauseIdx);
 
-    void watchLit(Literal lit, ClauseIndex clauseIdx);
+    /**
+     * @brief watchLit - adds the clause to the watch list of lit
+     * @param blocker - another literal of the clause, if it's true the clause is skipped
+     */
+    void watchLit(Literal lit, ClauseIndex clauseIdx, Literal blocker);
+
+    void unwatchLit(Literal lit, ClauseIndex clauseIdx);
+
+    void unwatchBinary(Literal lit, ClauseIndex clauseIdx);
+
+    /**
+     * @brief load - sets up the valuation and watches for the formula and adds its clauses
+     */
+    void load(const DimacsFormula &formula);
+
+    /**
+     * @brief load - the same for shared clauses, only their watches are set up
+     */
+    void load(const SharedClauses &clauses);
+
+    /**
+     * @brief resetVariables - sizes the valuation and the tables indexed by variables and literals
+     */
+    void resetVariables(unsigned nVars);
+
+    /**
+     * @brief isShared - whether the clause is one of m_shared rather than in m_formula
+     */
+    static bool isShared(ClauseIndex clauseIdx)
+    {
+        return clauseIdx & c_sharedClause;
+    }
+
+    /**
+     * @brief clause - the clause wherever it is stored; shared ones must not be changed
+     */
+    ArenaClause clause(ClauseIndex clauseIdx) const
+    {
+        return isShared(clauseIdx) ? (*m_shared)[clauseIdx] : m_formula[clauseIdx];
+    }
+
+    /**
+     * @brief updateSharedClause - updateWatchedClauses for a shared clause, which can't
+     * be reordered, so a new watched literal is searched for in the whole clause
+     * @return false if the other watched literal is false too (conflict)
+     */
+    bool updateSharedClause(WatchList &watchedClauses, unsigned &currClauseInd, Literal falseLit);
+
+    /**
+     * @brief addClause - stores the clause in the arena, without watching it
+     * @return index of the new clause
+     */
+    ClauseIndex addClause(const Clause& clause, bool learned);
+
+    /**
+     * @brief removeClause - stops watching the clause and frees its memory in the arena
+     */
+    void removeClause(ClauseIndex clauseIdx);
+
+    /**
+     * @brief proveUnsat - the formula is UNSAT without any assumptions, the proof ends with the empty clause
+     */
+    void proveUnsat();
+
+    /**
+     * @brief cleanWatches - drops watchers of deleted clauses from all watch lists
+     */
+    void cleanWatches();
+
+    /**
+     * @brief isLocked - checks if the clause is the reason of a currently assigned literal
+     */
+    bool isLocked(ClauseIndex clauseIdx) const;
+
+    void bumpClauseActivity(ArenaClause clause);
+
+    /**
+     * @brief reduceLearned - deletes the worse half of the learned clauses, ranked by LBD
+     * and then by activity. Locked, binary and glue clauses are kept.
+     */
+    void reduceLearned();
+
+    /**
+     * @brief relocateClauses - moves live clauses of the list into the arena and drops deleted ones
+     */
+    void relocateClauses(std::vector<ClauseIndex>& clauses, ClauseArena& to);
+
+    /**
+     * @brief checkGarbage - runs garbageCollect when enough of the arena is wasted
+     */
+    void checkGarbage();
+
+    /**
+     * @brief garbageCollect - compacts the arena by moving live clauses into a new one
+     * and fixes up clause indices in watch lists and reasons on the stack
+     */
+    void garbageCollect();
+
+    void changeWatchedLiteral(WatchList &watchedClauses,
+                unsigned currClauseInd, int currLitInd, int otherLitInd);
 
-    void changeWatchedLiteral(std::vector<ClauseIndex> &watchedClauses,
-                ClauseIndex currClauseInd, int currLitInd, int otherLitInd);
+    /**
+     * @brief updateBinaryClauses - propagates binary clauses of a literal that became false
+     * @param implications - implication list of the false literal
+     * @return conflicting binary clause, NullClause if there is none
+     */
+    ClauseIndex updateBinaryClauses(const BinaryList &implications);
 
-    ClauseIndex updateWatchedClauses(std::vector<ClauseIndex> &watchedClauses, Literal lit);
+    ClauseIndex updateWatchedClauses(WatchList &watchedClauses, Literal lit);
 
     void printAllWatchedClauses();
 
 private:
-    CNFFormula m_formula;
+    /**
+     * @brief c_garbageFraction - share of wasted arena memory which triggers a collection
+     */
+    const double c_garbageFraction = 0.2;
+
+    /**
+     * @brief c_glueLbd - learned clauses with LBD up to this are never deleted
+     */
+    const unsigned c_glueLbd = 2;
+
+    /**
+     * @brief c_firstReduce, c_reduceIncrement - conflicts before the first reduction of
+     * learned clauses, and how much the interval grows after each one
+     */
+    const unsigned long long c_firstReduce = 2000;
+    const unsigned long long c_reduceIncrement = 300;
+
+    /**
+     * @brief c_rephaseInterval - n-th rephase happens n * c_rephaseInterval conflicts after the previous one
+     */
+    const unsigned long long c_rephaseInterval = 1000;
+
+    /**
+     * @brief c_inprocessInterval - conflicts between two inprocessing rounds
+     */
+    const unsigned long long c_inprocessInterval = 5000;
+
+    /**
+     * @brief c_budgetCheckInterval - cheap budget checks between two looks at the clock and memory
+     */
+    const unsigned c_budgetCheckInterval = 256;
+
+    /**
+     * @brief c_probeLimit, c_vivifyLimit - most literals probed and learned clauses vivified in a round
+     */
+    const unsigned c_probeLimit = 1000;
+    const std::size_t c_vivifyLimit = 500;
+
+    /**
+     * @brief c_lookaheadCandidates - how many variables lookahead tries, the ones in most clauses
+     */
+    const std::size_t c_lookaheadCandidates = 64;
+
+    /**
+     * @brief c_exportLbd, c_exportSize - learned clauses with LBD or size up to these are shared
+     */
+    const unsigned c_exportLbd = 2;
+    const std::size_t c_exportSize = 8;
+
+    /**
+     * @brief c_preprocessTimeLimit - seconds which preprocessing may take at most
+     */
+    const double c_preprocessTimeLimit = 1.0;
+
+    const float c_clauseDecayFactor = 0.999f;
+    const float c_clauseRescaleLimit = 1e20f;
+
+    ClauseArena m_formula;
+    // original clauses read by other solvers too, if the solver was made from them
+    const SharedClauses* m_shared = nullptr;
+    // the two watched literals of every shared clause xor-ed together, by SharedClauses::watchSlot,
+    // so that one of them and the slot give the other one
+    std::vector<Literal> m_sharedWatches;
+    // indices of the original clauses, in the arena or shared
+    std::vector<ClauseIndex> m_clauses;
+    // indices of the learned clauses in the arena
+    std::vector<ClauseIndex> m_learned;
     PartialValuation m_valuation;
 
-    // Queues for unit literals and reason clauses, used with two watched literals
-    std::queue<ClauseIndex> unitClauses;
-    std::queue<Literal> unitLiterals;
+    // watch lists indexed by litIndex, kept apart from the valuation so that
+    // propagating a literal walks only its own list
+    std::vector<WatchList> m_watches;
+
+    // implication lists of binary clauses, also indexed by litIndex
+    std::vector<BinaryList> m_binWatches;
+
+    PropagationStats m_propStats;
+
+    LoadStats m_loadStats;
+    std::chrono::steady_clock::time_point m_created = std::chrono::steady_clock::now();
+
+    std::ostream* m_progressOut = nullptr;
+    unsigned long long m_progressInterval = c_defaultProgressInterval;
+    unsigned long long m_nextProgress = 0;
+
+    // per variable flags used by analyze, all of them are cleared between conflicts
+    std::vector<char> m_seen;
+
+    // buffer for the learned clause, reused between conflicts
+    Clause m_learnedClause;
+
+    // buffers of minimize, reused between conflicts
+    std::vector<Literal> m_analyzeStack;
+    std::vector<Literal> m_analyzeToClear;
+
+    LearningStats m_learnStats;
+
+    // stamps of levels already counted by computeLbd
+    std::vector<unsigned> m_levelStamps;
+    unsigned m_lbdStamp = 0;
+
+    std::unique_ptr<RestartPolicy> m_restartPolicy = RestartPolicy::create(RestartStrategy::Luby);
+    unsigned long long m_restarts = 0;
+
+    unsigned long long m_conflicts = 0;
+    unsigned long long m_reduceInterval = c_firstReduce;
+    unsigned long long m_nextReduce = c_firstReduce;
+    unsigned long long m_deletedClauses = 0;
+    float m_clauseIncrement = 1.0f;
+
+    // clauses of the variables eliminated by preprocessing, needed to complete the model
+    std::vector<Literal> m_eliminationStack;
+    PreprocessStats m_preprocessStats;
+    bool m_preprocessed = false;
+
+    InprocessStats m_inprocessStats;
+    unsigned long long m_nextInprocess = c_inprocessInterval;
+    // probing goes round all the variables, it continues where the last round stopped
+    unsigned m_nextProbe = 1;
+    // literals of the clause being vivified, and the ones which are kept
+    Clause m_vivifyLits;
+    Clause m_vivified;
+
+    ClauseSharing* m_sharing = nullptr;
+    // clauses from other solvers, each one as its LBD followed by its literals and a 0
+    std::vector<Literal> m_imported;
+    unsigned long long m_exportedClauses = 0;
+    unsigned long long m_importedClauses = 0;
+
+    ProofWriter* m_proof = nullptr;
+
+    // assumptions of the running solve, decided in order one per level before anything else
+    std::vector<Literal> m_assumptions;
+    std::vector<Literal> m_failedAssumptions;
+    OptionalPartialValuation m_model;
+
+    const std::atomic<bool>* m_terminate = nullptr;
+    std::atomic<bool> m_interrupt{false};
+    // cancel flag of the SolveHandle of the running solveAsync
+    const std::atomic<bool>* m_cancel = nullptr;
+    SolveBudget m_budget;
+    SolveResult m_status = SolveResult::Unknown;
+    StopReason m_stopReason = StopReason::Finished;
+
+    // limits of the running solve2 in absolute counts, 0 if there's none
+    unsigned long long m_conflictStop = 0;
+    unsigned long long m_propagationStop = 0;
+    std::chrono::steady_clock::time_point m_deadline;
+    // budget checks left until the clock and memory are looked at again
+    unsigned m_budgetCountdown = 0;
+
+    unsigned long long m_rephases = 0;
+    unsigned long long m_nextRephase = c_rephaseInterval;
+
+    // number of literals on the stack which are already propagated
+    std::size_t m_propagated = 0;
+
+    // false if the formula is found to be UNSAT, e.g. by contradicting unit clauses
+    bool m_ok = true;
+
+    unsigned long long m_decisions = 0;
 };
 
 #endif // SOLVER_H
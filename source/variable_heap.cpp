@@ -0,0 +1,143 @@
+#include "variable_heap.h"
+
+#include <random>
+
+VariableHeap::VariableHeap(unsigned nVars)
+{
+    reset(nVars);
+}
+
+void VariableHeap::reset(unsigned nVars)
+{
+    m_activity.assign(nVars+1, 0.0);
+    m_increment = 1.0;
+
+    // all activities are equal, so variables in order of their index make a valid heap
+    m_heap.clear();
+    m_heap.reserve(nVars);
+    m_indices.assign(nVars+1, -1);
+    for (unsigned var = 1; var <= nVars; var++)
+    {
+        m_indices[var] = m_heap.size();
+        m_heap.push_back(var);
+    }
+}
+
+void VariableHeap::grow(unsigned nVars)
+{
+    if (nVars < m_activity.size())
+    {
+        return;
+    }
+    unsigned oldVars = m_activity.size() - 1;
+    m_activity.resize(nVars+1, 0.0);
+    m_indices.resize(nVars+1, -1);
+    for (unsigned var = oldVars + 1; var <= nVars; var++)
+    {
+        insert(var);
+    }
+}
+
+void VariableHeap::randomize(unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> tiny(0.0, 1e-3 * m_increment);
+    for (unsigned var = 1; var < m_activity.size(); var++)
+    {
+        m_activity[var] += tiny(generator);
+    }
+
+    for (int pos = static_cast<int>(m_heap.size()) / 2 - 1; pos >= 0; pos--)
+    {
+        percolateDown(pos);
+    }
+}
+
+void VariableHeap::insert(unsigned var)
+{
+    if (contains(var))
+    {
+        return;
+    }
+    m_indices[var] = m_heap.size();
+    m_heap.push_back(var);
+    percolateUp(m_indices[var]);
+}
+
+unsigned VariableHeap::removeMax()
+{
+    unsigned top = m_heap[0];
+    m_heap[0] = m_heap.back();
+    m_indices[m_heap[0]] = 0;
+    m_indices[top] = -1;
+    m_heap.pop_back();
+    if (m_heap.size() > 1)
+    {
+        percolateDown(0);
+    }
+    return top;
+}
+
+void VariableHeap::bump(unsigned var)
+{
+    if ((m_activity[var] += m_increment) > c_rescaleLimit)
+    {
+        // scaling doesn't change the order, so the heap stays valid
+        for (double& a : m_activity)
+        {
+            a /= c_rescaleLimit;
+        }
+        m_increment /= c_rescaleLimit;
+    }
+
+    if (contains(var))
+    {
+        percolateUp(m_indices[var]);
+    }
+}
+
+void VariableHeap::decay()
+{
+    m_increment /= c_decayFactor;
+}
+
+void VariableHeap::percolateUp(int pos)
+{
+    unsigned var = m_heap[pos];
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (!higher(var, m_heap[parent]))
+        {
+            break;
+        }
+        m_heap[pos] = m_heap[parent];
+        m_indices[m_heap[pos]] = pos;
+        pos = parent;
+    }
+    m_heap[pos] = var;
+    m_indices[var] = pos;
+}
+
+void VariableHeap::percolateDown(int pos)
+{
+    unsigned var = m_heap[pos];
+    int size = m_heap.size();
+    while (2 * pos + 1 < size)
+    {
+        int child = 2 * pos + 1;
+        if (child + 1 < size && higher(m_heap[child + 1], m_heap[child]))
+        {
+            child++;
+        }
+        if (!higher(m_heap[child], var))
+        {
+            break;
+        }
+        m_heap[pos] = m_heap[child];
+        m_indices[m_heap[pos]] = pos;
+        pos = child;
+    }
+    m_heap[pos] = var;
+    m_indices[var] = pos;
+}
@@ -0,0 +1,103 @@
+#ifndef VARIABLE_HEAP_H
+#define VARIABLE_HEAP_H
+
+#include <vector>
+
+/**
+ * @brief The VariableHeap class - binary max-heap of variables ordered by their VSIDS activity.
+ *
+ * @details Activities are bumped by an increment which grows after every conflict, which is
+ * the same as decaying all the other activities, but costs O(1). When the increment gets too
+ * big all activities are rescaled. Assigned variables may stay in the heap, they are skipped
+ * when popped and inserted again when they're unassigned.
+ */
+class VariableHeap
+{
+public:
+    VariableHeap(unsigned nVars = 0);
+
+    /**
+     * @brief reset - sets all activities to 0 and puts all variables into the heap
+     * @param nVars - number of variables
+     */
+    void reset(unsigned nVars);
+
+    bool empty() const
+    {
+        return m_heap.empty();
+    }
+
+    bool contains(unsigned var) const
+    {
+        return m_indices[var] >= 0;
+    }
+
+    double activity(unsigned var) const
+    {
+        return m_activity[var];
+    }
+
+    /**
+     * @brief insert - puts the variable back into the heap, if it isn't already there
+     */
+    void insert(unsigned var);
+
+    /**
+     * @brief removeMax - removes the variable with the highest activity from the heap
+     * @return removed variable
+     */
+    unsigned removeMax();
+
+    /**
+     * @brief bump - increases activity of the variable by the current increment
+     */
+    void bump(unsigned var);
+
+    /**
+     * @brief grow - adds variables up to nVars with no activity, keeping the existing ones
+     */
+    void grow(unsigned nVars);
+
+    /**
+     * @brief randomize - adds a tiny random amount to every activity, which is smaller than
+     * any bump, and restores the heap
+     */
+    void randomize(unsigned seed);
+
+    /**
+     * @brief decay - grows the increment, so older bumps weigh less than the new ones
+     */
+    void decay();
+
+private:
+    bool higher(unsigned var1, unsigned var2) const
+    {
+        return m_activity[var1] > m_activity[var2];
+    }
+
+    void percolateUp(int pos);
+
+    void percolateDown(int pos);
+
+    /**
+     * @brief c_decayFactor - activities decay by this factor on every conflict
+     */
+    const double c_decayFactor = 0.95;
+
+    /**
+     * @brief c_rescaleLimit - activities are rescaled when some of them gets bigger than this
+     */
+    const double c_rescaleLimit = 1e100;
+
+    std::vector<double> m_activity;
+
+    double m_increment;
+
+    // variables ordered as a binary heap
+    std::vector<unsigned> m_heap;
+
+    // position of each variable in m_heap, -1 if it isn't in the heap
+    std::vector<int> m_indices;
+};
+
+#endif // VARIABLE_HEAP_H
@@ -0,0 +1,37 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include "choice.h"
+
+#include <vector>
+
+/**
+ * @brief The Watcher struct - entry of a watch list, one per watched literal of a clause
+ */
+struct Watcher
+{
+    ClauseIndex clause;
+    // some other literal of the clause, when it's true the clause needn't be visited
+    Literal blocker;
+};
+
+/**
+ * @brief WatchList - clauses watching one literal, the table of lists is indexed by litIndex
+ */
+using WatchList = std::vector<Watcher>;
+
+/**
+ * @brief The BinaryWatcher struct - implication stored for one literal of a binary clause
+ *
+ * @details When the literal becomes false the other one is implied. The clause itself is
+ * only needed as a reason during conflict analysis.
+ */
+struct BinaryWatcher
+{
+    Literal implied;
+    ClauseIndex clause;
+};
+
+using BinaryList = std::vector<BinaryWatcher>;
+
+#endif // WATCHER_H